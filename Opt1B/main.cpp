@@ -0,0 +1,10 @@
+//main.cpp.
+//      The ssat command line, built on the solver library in ssat.cpp. See the readme for argument options.
+//
+
+#include "ssat.h"
+
+int main(int argc, char* argv[])
+{
+	return runCommandLine(argc, argv);
+}
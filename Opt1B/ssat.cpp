@@ -20,495 +20,5426 @@
 #include <algorithm>
 #include <chrono>
 #include <climits>
+#include <cstdlib>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "ssat.h"
 
 //Specifies which solution the user would like
 enum SolutionType { naive, unit, pure, both, hOne, hTwo, hThree };
 
-// Reads in a file with an ssat problem and fills the vector of variables, vector of clauses, and vector of variables that
-// each contain a vector of the clause #s they appear in
-int readSSATFile(std::string fileName, std::vector<double>*, std::vector<std::vector<int>>*, std::vector<std::vector<int>>*);
+// The header of a compiled instance (see writeCompiledFile()), followed by the variable probabilities (doubles) and
+// then clauseStart, literals, occurrenceStart, occurrences and blockStart of the clause database (ints), as they are in memory
+struct CompiledHeader {
+    char magic[8];					// COMPILED_MAGIC
+    unsigned int version;			// COMPILED_VERSION
+    unsigned int numVars;
+    unsigned int numClauses;
+    unsigned int numLiterals;
+    unsigned int numBlocks;
+    unsigned int reserved;			// 0, keeps the doubles that follow 8-byte aligned
+    unsigned long long checksum;	// of everything after the header (see compiledChecksum())
+};
 
-// Solves the SSAT problem based on DPLL
-double solve(SolutionType, std::vector<double>*, std::vector<std::vector<int>>, std::vector<int>, std::vector<int>*, std::vector<std::vector<int>>);
+const char COMPILED_MAGIC[8] = { 'S', 'S', 'A', 'T', 'B', 'I', 'N', '\0' };
+const unsigned int COMPILED_VERSION = 1;
 
-// Sets clauses as satisfied or removes unsatisfied literals from those clauses
-void satisfyClauses(int, std::vector<std::vector<int>>*, std::vector<int>*, std::vector<int>*, std::vector<std::vector<int>>*);
+// The clauses and the clauses each literal appears in, stored flat so the whole formula lives in a few contiguous arrays
+// Literals are encoded as 2 * varIndex for the positive literal and 2 * varIndex + 1 for the negative one, so a literal
+// can index an array directly (see makeLiteral() and friends below)
+//
+// literals -- every clause's literals back to back, where clause c is literals[clauseStart[c] .. clauseStart[c+1])
+// clauseStart -- the offset of each clause in literals, plus one last entry for the end of the arena
+// occurrences -- the clause indexes each literal appears in, back to back, where literal l appears in the clauses
+//				  occurrences[occurrenceStart[l] .. occurrenceStart[l+1]) (so a variable's positive appearances are
+//				  immediately followed by its negative ones)
+// occurrenceStart -- the offset of each literal in occurrences, plus one last entry for the end of the arena
+// blockStart -- the first variable of each quantifier block (a run of choice or of chance variables in the prefix),
+//				 plus one last entry for the number of variables
+// blockOf -- the block each variable belongs to, so variable v lies in blockStart[blockOf[v]] .. blockStart[blockOf[v]+1]
+struct ClauseDatabase {
+    std::vector<int> literals;
+    std::vector<int> clauseStart;
+    std::vector<int> occurrences;
+    std::vector<int> occurrenceStart;
+    std::vector<int> blockStart;
+    std::vector<int> blockOf;
+
+    int numClauses() const { return clauseStart.size() - 1; }
+    int clauseLength(int c) const { return clauseStart[c + 1] - clauseStart[c]; }
+};
+
+// What a probability returned by solve() says about the true probability (see solve())
+enum BoundType { exactValue, upperBound, lowerBound };
+
+// One remembered residual formula: its two hashes (see Formula::residualHash), its success probability, whether
+// that probability is exact or only a bound (from a search cut short by its thresholds), and the number of nodes
+// it took to solve (so cheap entries are the first to be evicted)
+struct CacheEntry {
+    unsigned long long key;		// 0 marks an empty slot
+    unsigned long long check;
+    double probability;
+    BoundType bound;
+    long long work;
+};
+
+// Memoizes the success probability of residual formulas, so a subformula reached again through a different
+// assignment path is not solved twice. Open addressing over a table that doubles until it reaches the memory cap,
+// after which a new entry evicts the cheapest of the slots it could go in
+struct ComponentCache {
+    std::vector<CacheEntry> entries;
+    unsigned long long maxEntries;
+    unsigned long long used;
+
+    long long hits;
+    long long misses;
+    long long evictions;
+};
+
+// How many neighbouring slots an entry may sit in before something has to be evicted
+const int CACHE_PROBES = 4;
+
+// Kinds of circuit nodes. A constant is 0 or 1, a literal is the chance of a chance variable's value (p for its positive
+// literal, 1 - p for its negative one), a product multiplies its children, a choice node takes the larger of its two
+// children (its variable false, then true) and a chance node weighs them by the chance of its variable
+enum CircuitNodeType { zeroNode, oneNode, literalNode, productNode, choiceNode, chanceNode };
+
+// A search recorded as an arithmetic circuit over the chance probabilities (see --circuit), which gives the probability
+// of the instance for any chance probabilities in time linear in its size. Every node comes after its children, so
+// evaluating them in order ends with the root. Node n is of type types[n], with vars[n] the literal of a literal node or
+// the variable split on by a choice or chance node, and its children are children[childStart[n] .. childStart[n+1])
+// NOTE nodes 0 and 1 are the constants 0 and 1, and a part of the search that never reached a satisfied formula is
+// always node 0 itself (see productCircuitNode() and splitCircuitNode())
+struct Circuit {
+    std::vector<double> variables;	// the probabilities of the instance it was compiled from, -1 for a choice variable
+    std::vector<int> types;
+    std::vector<int> vars;
+    std::vector<int> childStart;
+    std::vector<int> children;
+    int root;
+};
+
+// The header of a circuit file (see writeCircuitFile()), followed by the variable probabilities (doubles) and then the
+// types, vars and childStart of the nodes and their children (ints), as they are in memory
+struct CircuitHeader {
+    char magic[8];					// CIRCUIT_MAGIC
+    unsigned int version;			// CIRCUIT_VERSION
+    unsigned int numVars;
+    unsigned int numNodes;
+    unsigned int numChildren;
+    unsigned int root;
+    unsigned int reserved;			// 0, keeps the doubles that follow 8-byte aligned
+    unsigned long long checksum;	// of everything after the header (see compiledChecksum())
+};
+
+const char CIRCUIT_MAGIC[8] = { 'S', 'S', 'A', 'T', 'C', 'I', 'R', '\0' };
+const unsigned int CIRCUIT_VERSION = 1;
+
+// How many probability vectors evaluateCircuit() works through side by side, each node's loop over them being the same
+// few arithmetic instructions with no branches, which the compiler can turn into vector instructions
+const int CIRCUIT_LANES = 8;
+
+// One residual formula of a circuit being built and its node (key 0 marks an empty slot)
+struct CircuitMemo {
+    unsigned long long key;
+    unsigned long long check;
+    int node;
+};
+
+// Records a search as a circuit (see solve()): the circuit so far, the node of the latest probability the search came
+// up with, the node of each literal once it has one, and the node of every residual formula solved, so the same
+// residual formula reached down another path is the same node. The memo is open addressing over a table that doubles
+// when it is half full, since the circuit keeps every node anyway
+struct CircuitBuilder {
+    Circuit circuit;
+    int result;
+    std::vector<int> literalNodes;
+    std::vector<CircuitMemo> memo;
+    unsigned long long memoUsed;
+    long long reused;				// residual formulas found in the memo
+};
+
+struct SolverPool;
+
+// Counts of what the search did, kept per formula and added together when a pool task is joined
+// NOTE the two times are only measured on one node in TIMING_SAMPLE (reading the clock on every node would cost more
+// than most nodes do), so they are scaled up by TIMING_SAMPLE when they are reported
+struct SolveStats {
+    long long nodes;			// calls to solve()
+    long long choiceSplits;		// nodes split on a choice variable
+    long long chanceSplits;		// nodes split on a chance variable
+    long long unitPropagations;	// variables assigned by a unit clause
+    long long pureEliminations;	// variables assigned because they were pure
+    long long conflicts;		// nodes with a clause whose every literal is false
+    int maxDepth;				// the most variables assigned at once, which is how deep the search went
+    long long componentSplits;	// residual formulas split into components
+    long long boundCutoffs;		// nodes returned straight away because nothing they could return would matter
+    long long choiceCutoffs;	// second branches of choice splits skipped because the first one was high enough
+    long long chanceCutoffs;	// second branches of chance splits skipped because the first one was too low or high enough
+    long long learnedClauses;	// clauses learned from conflicts
+    long long learnedDeletions;	// learned clauses deleted to make room for new ones
+    double heuristicTime;		// seconds spent choosing the variable to split on (sampled)
+    double propagationTime;		// seconds spent assigning variables and updating the clauses and watches (sampled)
+};
+
+// One node in this many has its heuristic and propagation times measured (a power of two)
+const long long TIMING_SAMPLE = 64;
+
+// Every this many nodes (a power of two) a formula checks whether a progress line is due
+const long long PROGRESS_CHECK_NODES = 1 << 16;
+
+// A progress line every interval seconds during a long solve (see reportProgress()), shared by every formula of the solve
+// NOTE nodes only counts the nodes of each formula in steps of PROGRESS_CHECK_NODES, so it runs a little behind
+struct ProgressReport {
+    double interval;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point next;
+    std::atomic<long long> nodes;
+    std::mutex lock;
+};
+
+// Kinds of steps on the path from the root to the node being solved, as a budgeted search keeps them (see BoundFrame)
+enum BoundFrameType { choiceFrame, chanceFrame, scaleFrame, componentFrame };
+
+// One step on the path from the root to the node being solved, holding what is already known about the rest of it
+// NOTE the choices are only kept for component frames before the first chance split (see anytimeLeaf())
+struct BoundFrame {
+    BoundFrameType type;
+    double probability;			// chance of the true branch (chanceFrame), the weight of the unit chance variables
+								// (scaleFrame), or the product of the finished components (componentFrame)
+    bool second;				// working on the true branch (splits), or on the last component (componentFrame)
+    double first;				// the probability of the false branch, once second is set
+    unsigned int trailMark;		// the trail size when the step was taken
+    double partLower;			// the best lower bound on the component being solved (componentFrame)
+    std::vector<int> partChoices;	// the choices that reach partLower
+    std::vector<int> doneChoices;	// the best choices of the finished components
+};
+
+// A search with a time or node budget (see --time-limit and --node-limit), which keeps lower and upper bounds on the
+// probability as it goes, and the choices made before the first chance split on the way to the lower bound
+// NOTE only for a single-threaded search with exact thresholds, so every probability a finished subtree returns is exact
+struct AnytimeSearch {
+    double timeLimit;			// seconds, or 0 for none
+    long long nodeLimit;		// nodes, or 0 for none
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point nextReport;
+    double reportInterval;		// seconds between lines about tighter bounds, or 0 for none
+    bool stopped;
+    bool timedOut;
+
+    std::vector<BoundFrame> frames;
+    unsigned int leadingFrames;	// how many frames come before the first chance split
+
+    double lower;
+    double upper;
+    double lowerTime;			// when the lower bound was last raised, in seconds
+    std::vector<int> bestChoices;	// signed variable numbers, as in an instance file
+};
+
+// Every this many nodes (a power of two) a budgeted search checks the clock
+const long long ANYTIME_CHECK_NODES = 1 << 10;
+
+struct SolveTask;
+
+// Where a suspended step of the search carries on once the one it is waiting on has returned (see SearchFrame)
+enum SearchStep { afterPropagated, afterResidual, afterFalse, afterTrue, afterComponent };
+
+// A suspended step of the search, holding everything it needs to carry on once the node it is waiting on is solved
+struct SearchFrame {
+    SearchStep step;
+    unsigned int trailMark;		// what to undo back to
+    double low;					// the step's own thresholds (see solve())
+    double high;
+
+    int varIndex;				// afterFalse, afterTrue: the variable split on and whether it is a choice variable, whether
+    bool choice;				// the node's times are measured (see SolveStats), the chance of its true branch, the thresholds
+    bool timed;					// of its false branch and its result, and the task its true branch was handed to (if any)
+    double trueProb;
+    double falseLow;
+    double falseHigh;
+    double probSatFalse;
+    int falseNode;				// and the circuit node of its false branch, when recording one
+    SolveTask* trueTask;
+
+    double weight;				// afterPropagated: the chance of the values the unit chance variables were given
+
+    long long nodesBefore;		// afterResidual: the node count before the residual formula, and its hashes
+    unsigned long long key;
+    unsigned long long check;
+
+    int component;				// afterComponent: the component being solved, how many there are, where they start in
+    int numComponents;			// Formula::componentStarts and how much of it and componentClauses to give back after,
+    unsigned int startsAt;		// the product so far, the low threshold of the current one, and the frame a budgeted
+    unsigned int clausesAt;		// search keeps for them
+    double probability;
+    double componentLow;
+    unsigned int boundFrame;
+    int productNode;			// the circuit node of the product so far, when recording one
+};
+
+// Kinds of changes that solve() makes to the formula and must undo when it backtracks
+enum TrailType { setAssignment, setClauseSat, shortenClause, pushUnit, setUnitHead, pushPure, setPureHead, setConflict };
+
+// A single recorded change to the formula, holding enough to put the old state back
+struct TrailEntry {
+    TrailType type;
+    int index;		// variable index (assignments) or clause index (clauseSats, clauseLengths), unused for the queues and conflict
+    int value;		// the old assignment/satisfaction value, the literal a shortened clause lost, or the old queue head
+};
+
+// Scores a variable for a splitting heuristic from the active occurrences of its positive and negative literal and its
+// probability (-1 for a choice variable). The unassigned variable of the current block with the highest score is split on
+// NOTE a score may only depend on these, since they are what ScoreHeap updates on
+typedef double (*VariableScore)(int positive, int negative, double probability);
+
+// An indexed max-heap of the unassigned variables of each quantifier block by score, so a splitting heuristic can pick its
+// variable off the top and keep the scores up to date in O(log n) as occurrences come and go (see initScores()). Block b's
+// heap is heap[blockStart[b] .. blockStart[b] + heapSize[b]), ordered by score and then by lowest variable, and positions[v]
+// is where variable v is in it (-1 while it is assigned)
+// NOTE a variable whose occurrences change is only marked stale, and rescored when the next split looks at the heap (see
+// refreshScores()), so it moves at most once however often it changed, and not at all when a branch was undone in between
+struct ScoreHeap {
+    VariableScore score;		// NULL when no heuristic uses the heap
+    const std::vector<double>* variables;
+    std::vector<double> scores;
+    std::vector<int> heap;
+    std::vector<int> positions;
+    std::vector<int> heapSize;
+    std::vector<int> staleVars;
+    std::vector<char> stale;
+};
+
+// Clauses learned from conflicts (see learnClause()), which are watched and propagated like the clauses of the database
+// but take no part in anything else: the satisfied count, occurrences, residual hashes and components only ever see the
+// database. To the watches and unit reasons, learned clause k is clause numClauses() + k, and its literals are
+// literals[start[k] .. start[k] + length[k]). The number of a clause never changes while it is kept, and once it is
+// deleted its number is handed out again
+// NOTE a learned clause is a resolvent of clauses the formula already has, so it holds in every assignment that satisfies
+// the database and adding it changes no probability, whatever the order of choice and chance blocks
+struct LearnedClauses {
+    int limit;					// the most clauses kept at once, or 0 to learn none
+    std::vector<int> literals;
+    std::vector<int> start;
+    std::vector<int> length;	// -1 for a deleted clause
+    std::vector<double> activity;	// how much each clause has been used in conflicts lately
+    std::vector<int> freeSlots;		// the numbers of deleted clauses
+    int live;					// how many clauses are kept
+    int garbage;				// how many literals of deleted clauses are still in the arena
+    double bump;				// what using a clause in a conflict adds to its activity (grows so older uses count for less)
+    int pending;				// the latest learned clause, which the next node checks for being unit (see assertLearned()), or -1
+};
+
+// Every conflict makes later uses of a learned clause count this much more than earlier ones (one over this)
+const double LEARNED_DECAY = 0.999;
+
+// The single mutable state of the formula during a solve. Every change made while searching
+// is pushed on the trail so a branch can be rolled back instead of copying the whole formula
+// NOTE the clauses themselves are never changed, a clause only keeps track of how many of its literals are not yet false
+struct Formula {
+    const ClauseDatabase* database;
+    std::vector<int> clauseSats;
+    std::vector<int> clauseLengths;
+    std::vector<int> assignments;
+    std::vector<TrailEntry> trail;
+
+    // Running totals kept up to date by satisfyClauses() (and put back by undoTrail()), so nothing has to rescan
+    // the clauses: the number of satisfied clauses, and for each literal the number of unsatisfied clauses
+    // in which it still appears and is not false (see activeAppearances())
+    unsigned int numSatisfied;
+    std::vector<int> activeOccurrences;
+
+    // Literals that became pure when the last active occurrence of their negation went away (see dropOccurrence()),
+    // in the order that happened, and pureHead the first one solve() has not yet looked at
+    // NOTE a literal stays pure deeper in the search until its variable is assigned or loses its last active occurrence,
+    // since the counts only go down, so each candidate only needs checking once per branch
+    std::vector<int> pureQueue;
+    unsigned int pureHead;
+
+    // Two watched literals per clause for unit propagation. watched[2c] and watched[2c+1] are positions
+    // in clause c and watchLists[lit] holds every clause currently watching that literal
+    // NOTE watches are moved but never restored on backtrack, since undoing assignments can't break them
+    std::vector<int> watched;
+    std::vector<std::vector<int>> watchLists;
+
+    // Literals forced by clauses that have become unit, in the order they were found, the clause that forced
+    // each one, and unitHead the first one solve() has not yet looked at
+    std::vector<int> unitQueue;
+    std::vector<int> unitReasons;
+    unsigned int unitHead;
+
+    // Set when propagation finds a clause with every literal false, and the first clause it found (-1 for an empty clause)
+    bool conflict;
+    int conflictClause;
+
+    // The clauses learned from conflicts (see learnClause()), and for each assigned variable the clause that forced it
+    // (-1 for a split or a pure variable) and how many variables were assigned before it, which is what conflicts are
+    // traced back through, and the scratch marks and clause learnClause() works in
+    LearnedClauses learned;
+    std::vector<int> reasons;
+    std::vector<int> assignedAt;
+    std::vector<char> seen;
+    std::vector<int> seenVars;
+    std::vector<int> learnedClause;
+
+    // The unassigned variables of each quantifier block, so the splitting heuristics only look at live candidates.
+    // blockVars holds every variable grouped by block (block b in blockVars[blockStart[b] .. blockStart[b+1])), with the
+    // blockFree[b] unassigned ones first, and blockPositions[v] is where variable v is in it. assignVariable() swaps a
+    // variable to the end of its block's unassigned ones, and since undoTrail() unassigns in the opposite order, it only
+    // has to count it back in
+    std::vector<int> blockVars;
+    std::vector<int> blockPositions;
+    std::vector<int> blockFree;
+
+    // The scores of splitting heuristics two and three (see initScores())
+    ScoreHeap scores;
+
+    // Two independent hashes of the residual formula (the unsatisfied clauses and which of their literals are false),
+    // kept up to date by satisfyClauses() and undoTrail(). Each is the sum of a random key per satisfied clause and
+    // per false literal in an unsatisfied clause, so together they name the residual formula and with it the
+    // still relevant variables (an assigned or unassigned variable that appears in no unsatisfied clause doesn't change them)
+    unsigned long long residualHash[2];
+
+    // The residual formula cache, or NULL if it is turned off, what the search has done so far, how many variables are
+    // assigned, and where progress lines go (NULL for none)
+    ComponentCache* cache;
+    SolveStats stats;
+    int numAssigned;
+    ProgressReport* progress;
+
+    // The budget and bounds of an anytime search, or NULL to search until the answer is known
+    AnytimeSearch* anytime;
+
+    // The circuit the search is being recorded as, or NULL for none (see solve())
+    CircuitBuilder* circuit;
+
+    // The suspended steps of the search, of which the first searchDepth are in use. Rather than recursing, solve() keeps
+    // them here, so how deep the search can go is only limited by memory. The array only grows, so once the search has
+    // been somewhere that deep, going there again costs no allocation
+    std::vector<SearchFrame> searchStack;
+    unsigned int searchDepth;
+
+    // The components of every component split on the current path, one split after another (see findComponents())
+    std::vector<int> componentClauses;
+    std::vector<int> componentStarts;
+
+    // Whether to cut off choice branches that can't change the answer (see solve())
+    bool prune;
+
+    // Whether to split the residual formula into variable-disjoint components and solve them separately, and
+    // the scratch marks used to find them (a variable or clause belongs to the current search when its
+    // mark equals componentStamp)
+    bool components;
+    std::vector<int> varMarks;
+    std::vector<int> clauseMarks;
+    int componentStamp;
+
+    // The thread pool to hand subtrees to (NULL to solve on this thread only), which worker of that pool this
+    // formula is being solved on, and how many splits deep the search is
+    SolverPool* pool;
+    int worker;
+    int decisionDepth;
+};
+
+// An instantiation of solve() for one solution type (see solverFor())
+typedef double (*SolveFunction)(std::vector<double>*, Formula*, double, double);
+
+// Branching rules, which pick the variable to split on out of the unassigned variables of the current block, given the
+// default one (the lowest). A new heuristic is a class with the same pick() and a SolvePolicy that uses it
+// @param variables -- a pointer to a vector of variables' probabilities
+// @param formula -- the formula being solved (ptr)
+// @param block -- the current block, the first with unassigned variables
+// @param nextVarIndex -- the default variable
+struct FirstBranch {
+    static int pick(std::vector<double>* variables, Formula* formula, int block, int nextVarIndex) { return nextVarIndex; }
+};
+
+// Heuristic one: the variable of the current block in the smallest current clause
+struct SmallestClauseBranch {
+    static int pick(std::vector<double>*, Formula*, int, int);
+};
+
+// Heuristics two and three: the variable on top of the current block's score heap (see ScoreHeap and initScores())
+struct BestScoreBranch {
+    static int pick(std::vector<double>*, Formula*, int, int);
+};
+
+// What solve() does at every node: whether it looks for unit clauses and pure variables, and the Branch rule it splits by.
+// solve() is compiled once for each policy, so none of this is decided while searching
+template <bool unitRule, bool pureRule, class Branch>
+struct SolvePolicy {
+    static const bool units = unitRule;
+    static const bool pures = pureRule;
+    typedef Branch Branching;
+};
+
+// The policies of the solution types (heuristics two and three only differ in the score their heaps hold)
+typedef SolvePolicy<false, false, FirstBranch> NaivePolicy;
+typedef SolvePolicy<true, false, FirstBranch> UnitPolicy;
+typedef SolvePolicy<false, true, FirstBranch> PurePolicy;
+typedef SolvePolicy<true, true, FirstBranch> BothPolicy;
+typedef SolvePolicy<true, true, SmallestClauseBranch> SmallestClausePolicy;
+typedef SolvePolicy<true, true, BestScoreBranch> BestScorePolicy;
+
+// A subtree handed to the pool: the true branch of a split, with its own copy of the formula as it stood
+// at the split (and its own cache), so it can be solved on any thread without touching the parent's state
+// NOTE the result only depends on the task, not on which thread runs it or when, so the parent's combination is
+// the same from run to run
+struct SolveTask {
+    SolveFunction solve;
+    std::vector<double>* variables;
+    int varIndex;
+    double low;
+    double high;
+    Formula formula;
+    ComponentCache cache;
+
+    double result;
+    std::atomic<bool> done;
+};
+
+// A work-stealing pool: every worker pushes and pops the tasks it spawns at the back of its own queue, and an idle
+// worker steals from the front of someone else's (the oldest, so biggest, subtrees). Splits are only handed out
+// above spawnDepth decisions and while at least MIN_SPAWN_CLAUSES clauses are left, below which it's all sequential
+struct SolverPool {
+    int numThreads;
+    int spawnDepth;
+    unsigned int cacheMB;		// the cache cap of the whole solve, split between the threads
+
+    std::vector<std::deque<SolveTask*>> queues;
+    std::vector<std::mutex> locks;
+    std::atomic<bool> stop;
+
+    std::atomic<long long> spawned;
+    std::atomic<long long> stolen;
+};
+
+// A batch run (see runBatch()): the instances and solution types to pair up, the options every solve gets, and the
+// next instance for a worker to take. Each worker solves one instance at a time with every solution type, on its own
+// formula, and rows are written under outputLock as they finish
+struct Batch {
+    std::vector<std::string> files;
+    std::string typeNames;			// one letter per solution type, as on the command line
+    std::vector<SolutionType> types;
+
+    unsigned int cacheMB;
+    bool components;
+    bool prune;
+    bool decide;
+    double threshold;
+    bool preprocess;
+    int learnLimit;
+    bool json;
+
+    std::atomic<unsigned int> next;
+    std::atomic<int> failures;
+    std::mutex outputLock;
+};
+
+// The shape of a random k-SSAT instance (see generateSSAT())
+struct GeneratorOptions {
+    int numVars;
+    double ratio;			// clauses per variable
+    int k;					// literals per clause
+    int blocks;				// quantifier blocks, alternating between choice and chance
+    bool choiceFirst;		// whether the first block is choice (otherwise chance)
+    double probLow;			// chance variable probabilities are drawn from [probLow, probHigh]
+    double probHigh;
+    unsigned long long seed;
+};
+
+// A loaded SsatInstance (see ssat.h): the variable probabilities (-1 for a choice variable) and the clauses, which no
+// solve ever changes
+struct SsatInstance::Data {
+    std::vector<double> variables;
+    ClauseDatabase database;
+};
+
+// The state of an SsatSolver (see ssat.h). It has its own copy of the probabilities, holding the overrides of the latest
+// query, and a formula that every query is solved on. The cache and the scores of heuristic three are worked out with
+// the probabilities, so they are started over whenever the overrides change, while learned clauses follow from the
+// clauses alone and carry over from query to query
+struct SsatSolver::State {
+    const SsatInstance::Data* instance;
+    SsatOptions options;
+    std::string error;				// why the options can't be solved with, or empty
+    SolutionType directions;
+    SolveFunction solve;
+
+    std::vector<double> variables;
+    std::vector<SsatOverride> overrides;
+
+    Formula formula;
+    ComponentCache cache;
+};
+
+// Fewest unsatisfied clauses a residual formula must have for its split to be handed to the pool
+const int MIN_SPAWN_CLAUSES = 16;
+
+// How far below the threshold of --threshold a probability still counts as reaching it, so that rounding in the
+// thresholds worked out for each branch can't turn a probability sitting right on the threshold into the wrong answer
+const double DECISION_TOLERANCE = 1e-9;
+
+// Reads in a file with an ssat problem and fills the vector of variables and the clause database
+int readSSATFile(std::string fileName, std::vector<double>*, ClauseDatabase*, std::ostream*);
+
+// Walks the lines of a mapped .ssat file, either checking and counting its variables, clauses and literals or filling them in
+int scanSSAT(const char*, const char*, bool, std::vector<double>*, ClauseDatabase*, int*, int*, int*, std::ostream*);
+
+// Reads an integer in place, moving past it, and returns false if there isn't one before the end of the line
+bool scanInt(const char**, const char*, int*);
+
+// Reads a decimal number in place, moving past it, and returns false if there isn't one before the end of the line
+bool scanDouble(const char**, const char*, double*);
+
+// Fills in the occurrence lists of a clause database whose clauses have been added
+void buildOccurrences(ClauseDatabase*, int);
+
+// Fills in the quantifier block boundaries of a clause database from the variable probabilities
+void buildBlocks(const std::vector<double>&, ClauseDatabase*);
+
+// Fills in the block of each variable from the block starts
+void buildBlockIndex(ClauseDatabase*);
+
+// Fills the vector of variables and the clause database from a mapped compiled instance
+int readCompiledFile(const char*, size_t, std::vector<double>*, ClauseDatabase*, std::ostream*);
+
+// Checks the arrays of a compiled instance before anything indexes with them
+bool validCompiledArrays(unsigned long long, const ClauseDatabase&);
+
+// Writes the variables and clause database out as a compiled instance
+int writeCompiledFile(std::string, const std::vector<double>&, const ClauseDatabase&);
+
+// A checksum of a block of memory, used to validate compiled instances
+unsigned long long compiledChecksum(const char*, size_t);
+
+// Simplifies the clauses of an instance without changing its probability, reporting what each pass did
+void preprocessSSAT(const std::vector<double>&, ClauseDatabase*, std::ostream*);
+
+// Checks whether one sorted clause subsumes another, or would after flipping one of its literals
+int subsumeLiteral(const std::vector<int>&, const std::vector<int>&);
+
+// The variables of a clause as a 64 bit mask, to rule out most subsumption checks at once
+unsigned long long clauseSignature(const std::vector<int>&);
+
+// Assigns every queued unit literal until there are none left or a clause fails, returning false on a conflict
+bool propagateUnits(Formula*, const std::vector<double>*, double*);
+
+// Sets up a fresh, fully unassigned formula state over a clause database
+void initFormula(Formula*, const ClauseDatabase*, int);
+
+// Solves the SSAT problem based on DPLL, the way a SolvePolicy says
+template <class Policy> double solve(std::vector<double>*, Formula*, double, double);
+
+// Suspends a step of the search on the formula's search stack
+SearchFrame* pushSearch(Formula*, SearchStep);
+
+// Starts a node of the search, propagating its unit clauses
+template <class Policy> bool startNode(std::vector<double>*, Formula*, double*, double*, double*);
+
+// Checks a fully propagated formula for a conflict, satisfaction, its thresholds and the cache before solving its residual
+template <class Policy> bool startPropagated(std::vector<double>*, Formula*, double*, double*, double*);
+
+// Starts on a residual formula that is neither satisfied nor failed yet, by pure elimination, components or splitting
+template <class Policy> bool startResidual(std::vector<double>*, Formula*, double*, double*, double*);
+
+// Carries on with the suspended step on top of the search stack, once the node it was waiting on is solved
+bool resumeSearch(Formula*, double*, double*, double*);
+
+// Carries on with a split after its false branch, returning whether its true branch still has to be solved
+bool resumeSplit(Formula*, SearchFrame*, double*, double*, double*);
+
+// Combines the two branches of a split
+double finishSplit(Formula*, SearchFrame*, double);
+
+// Picks the instantiation of solve() for a solution type
+SolveFunction solverFor(SolutionType);
+
+// Whether a solve with a solution type, with or without components, can learn clauses
+bool learnsClauses(SolutionType, bool);
+
+// Sets clauses as satisfied or shortens them by their unsatisfied literals
+void satisfyClauses(int, Formula*);
+
+// Marks a single clause as satisfied, taking it out of the residual formula
+void satisfyClause(int, Formula*);
+
+// Splits the residual formula into its variable-disjoint components, returning how many there are
+int findComponents(Formula*, std::vector<int>*, std::vector<int>*);
+
+// Solves each component of a split residual formula on its own and multiplies their probabilities
+bool startComponents(Formula*, double*, double*, unsigned int, unsigned int);
+void startComponent(Formula*, SearchFrame*, double*, double*);
+bool resumeComponents(Formula*, SearchFrame*, double*, double*, double*);
+
+// Assigns a variable and records the change on the trail
+void assignVariable(int, int, Formula*);
+
+// Rolls the formula back to the given trail size
+void undoTrail(Formula*, unsigned int);
+
+// Sets up the two watched literals of every clause and queues the clauses that are unit from the start
+void initWatches(Formula*);
+
+// Moves watches off a literal that has just become false, queueing any unit clauses and flagging conflicts
+void propagateWatches(int, Formula*);
+
+// Returns the next queued unit literal whose variable is still unassigned, or -1 if there is none
+int nextUnit(Formula*);
+
+// The literals of a clause of the database or a learned one, and how many there are
+const int* clauseLiterals(const Formula*, int, int*);
+
+// Traces the conflict of the current node back to the clauses that caused it and learns their resolvent
+void learnClause(Formula*);
+
+// Deletes the less active half of the learned clauses that aren't the reason of a queued unit
+void reduceLearned(Formula*);
+
+// Queues the latest learned clause's literal if the clause has become unit since it was learned
+void assertLearned(Formula*);
+
+// Takes one active occurrence away from a literal, queueing its negation if that leaves it pure
+void dropOccurrence(int, Formula*);
+
+// Sets up the score heaps for the splitting heuristic of a solution type, if it uses them
+void initScores(Formula*, const std::vector<double>*, SolutionType);
+
+// The scores of splitting heuristics two and three
+double appearanceScore(int, int, double);
+double weightedScore(int, int, double);
+
+// Marks a variable whose active occurrences have changed for rescoring
+void updateScore(int, Formula*);
+
+// Rescores every stale variable, moving it in its block's heap
+void refreshScores(Formula*);
+
+// Puts an unassigned variable into its block's heap, or takes an assigned one out
+void insertScore(int, Formula*);
+void removeScore(int, Formula*);
+
+// Moves a heap entry up or down its block's heap until it is in order
+void siftScore(int, int, int, ScoreHeap*);
+
+// Returns the next queued pure literal of an unassigned choice variable, or -1 if there is none
+int nextPure(std::vector<double>*, Formula*);
+
+// Solves the true branch of a split on a formula of its own, as a pool task
+void runTask(SolveTask*, int);
+
+// Takes a task off the worker's own queue, or steals one from another worker, or returns NULL
+SolveTask* findTask(SolverPool*, int);
+
+// Waits for a spawned task to finish, running it here if nobody has stolen it, and returns its result
+double joinTask(SolverPool*, SolveTask*, int);
+
+// The loop run by every pool thread but the main one until the solve is done
+void runWorker(SolverPool*, int);
+
+// Sets up an empty residual formula cache that may grow to the given number of megabytes
+void initCache(ComponentCache*, unsigned int);
+
+// Looks up a residual formula in the cache, filling in its probability if it is there and good enough for the thresholds
+bool cacheLookup(ComponentCache*, unsigned long long, unsigned long long, double, double, double*);
+
+// Remembers the probability (or a bound on it) of a residual formula
+void cacheStore(ComponentCache*, unsigned long long, unsigned long long, double, BoundType, long long);
+
+// Sets up an empty circuit for a search of an instance to be recorded as
+void initCircuit(CircuitBuilder*, const std::vector<double>&);
+
+// Adds a node to a circuit, returning its number
+int addCircuitNode(CircuitBuilder*, CircuitNodeType, int, const int*, int);
+
+// The node of a literal, the product of two nodes, and the node of a split on a variable, folding constants away
+int literalCircuitNode(CircuitBuilder*, int);
+int productCircuitNode(CircuitBuilder*, int, int);
+int splitCircuitNode(CircuitBuilder*, bool, int, int, int);
+
+// The node of a probability scaled by the chance of the values given to the unit chance variables past a trail position
+int scaledCircuitNode(Formula*, int, unsigned int);
+
+// Looks up the node of a residual formula in a circuit's memo, and remembers it
+bool circuitLookup(CircuitBuilder*, unsigned long long, unsigned long long, int*);
+void circuitStore(CircuitBuilder*, unsigned long long, unsigned long long, int);
+
+// Evaluates a circuit for a number of chance probability vectors at once
+void evaluateCircuit(const Circuit&, const std::vector<double>&, int, std::vector<double>*);
+
+// Writes a circuit out, and reads one back in after checking it
+int writeCircuitFile(std::string, const Circuit&);
+int readCircuitFile(std::string, Circuit*, std::ostream*);
+
+// Evaluates a circuit file for the probability vectors of another file, writing one probability per line
+int runEvaluate(int, char*[]);
+
+// Adds one set of search counts to another
+void addStats(SolveStats*, const SolveStats&);
+
+// The error at the end of what a reader wrote to its log, without the "Exiting."
+std::string lastError(const std::string&);
+
+// Writes search counts (and cache counts, if there is a cache) as a JSON object
+std::string statsJson(const SolveStats&, const ComponentCache*, double);
+
+// Counts a formula's latest nodes toward a progress report and writes a progress line if one is due
+void reportProgress(Formula*);
+
+// Checks a budgeted search's budget, returning false once it has run out
+bool keepSearching(Formula*);
+
+// Folds the probability of a node whose answer is known up the path to the root, tightening a budgeted search's bounds
+void anytimeLeaf(const std::vector<double>*, Formula*, double);
+
+// Starts and ends a step on the path of a budgeted search
+void pushBoundFrame(Formula*, BoundFrameType, double);
+void popBoundFrame(Formula*);
+
+// The choices on the path of a budgeted search before its first chance split, from a trail position and a frame on
+std::vector<int> leadingChoices(const std::vector<double>*, Formula*, unsigned int, unsigned int);
+
+// The wall clock in seconds, for the sampled times in SolveStats
+inline double phaseClock() { return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+// Turns a command line solution type letter into its SolutionType, returning false if there is no such type
+bool parseDirections(const std::string&, SolutionType*);
+
+// Solves every instance of a manifest or directory with every given solution type, streaming one row per pair
+int runBatch(int, char*[]);
+
+// Fills in the instance files named by a manifest, or found in a directory
+int listInstances(std::string, std::vector<std::string>*);
+
+// Takes instances off a batch and solves them until there are none left
+void runBatchWorker(Batch*);
+
+// Writes a string as a CSV field or a JSON string, quoting and escaping it as needed
+std::string csvField(const std::string&);
+std::string jsonString(const std::string&);
+
+// Times satisfyClauses() on generated formulas of growing size to show its cost follows occurrences, not formula size
+void benchSatisfyClauses();
+
+// Reads a generator option at argv[a], moving past its value, and returns false if it isn't one
+bool parseGeneratorOption(int, char*[], int*, GeneratorOptions*);
+
+// Fills the vector of variables and the clause database with a random k-SSAT instance
+void generateSSAT(const GeneratorOptions&, std::vector<double>*, ClauseDatabase*);
+
+// Writes the variables and clauses out in the .ssat text format
+int writeSSATFile(std::string, const std::vector<double>&, const ClauseDatabase&);
+
+// Solves generated instances of growing size with every solution type, reporting timings and checking them against naive
+int runSweep(int, char*[]);
+
+// The next number of a seeded generator, so generated instances are the same on every platform
+inline unsigned long long nextRandom(unsigned long long* state)
+{
+	unsigned long long x = (*state += 0x9e3779b97f4a7c15ULL);
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+// Literal encoding helpers (see ClauseDatabase)
+inline int makeLiteral(int varIndex, bool negative) { return 2 * varIndex + (negative ? 1 : 0); }
+inline int literalVar(int literal) { return literal >> 1; }
+inline bool literalNegative(int literal) { return (literal & 1) == 1; }
+inline int negateLiteral(int literal) { return literal ^ 1; }
+
+// The random key of a clause (when satisfied) or of one of its literals (when false) for residual hash h (0 or 1)
+// NOTE the mix is splitmix64, literal -1 is used for the clause itself
+inline unsigned long long residualKey(int clause, int literal, int h)
+{
+	unsigned long long x = ((unsigned long long)clause << 32) + (unsigned int)(literal + 1) + (h == 0 ? 0x9e3779b97f4a7c15ULL : 0xd1b54a32d192ed03ULL);
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+// The value of a literal under the current assignments: -1 false, 0 unassigned, 1 true
+inline int literalValue(int literal, const std::vector<int>& assignments)
+{
+	int value = assignments[literalVar(literal)];
+	return literalNegative(literal) ? -value : value;
+}
+
+// The number of unsatisfied clauses in which a variable still appears as an active literal, of either sign
+inline int activeAppearances(int varIndex, const Formula& formula)
+{
+	return formula.activeOccurrences[2*varIndex] + formula.activeOccurrences[2*varIndex + 1];
+}
+
+
+// The command line -- reads in the cmd args, runs File I/O, runs the SSAT solver, and reports statistics (main.cpp's
+// main() just calls this, so the rest of this file can be linked into other programs as a library, see ssat.h)
+int runCommandLine(int argc, char* argv[])
+{
+
+	// A lone "bench" argument runs the satisfyClauses() benchmark instead of solving a file
+	if (argc == 2 && std::string(argv[1]).compare("bench") == 0) {
+		benchSatisfyClauses();
+		return 0;
+	}
+
+	// "--compile [filename] [output]" reads an instance and writes it back out compiled, so later runs can load it without parsing
+	if (argc == 4 && std::string(argv[1]).compare("--compile") == 0) {
+		std::vector<double> variables;
+		ClauseDatabase database;
+
+		if (readSSATFile(argv[2], &variables, &database, &std::cout) == 1)
+			return 1;
+
+		return writeCompiledFile(argv[3], variables, database);
+	}
+
+	// "generate [output] [options]" writes a random instance, and "sweep [options]" benchmarks the solution types on them
+	if (argc >= 3 && std::string(argv[1]).compare("generate") == 0) {
+		GeneratorOptions options = { 20, 4.0, 3, 2, true, 0.0, 1.0, 1 };
+
+		for (int a = 3; a < argc; a++) {
+			if (!parseGeneratorOption(argc, argv, &a, &options)) {
+				std::cout << "Unknown option " << argv[a] << ". Exiting." << std::endl;
+				return 1;
+			}
+		}
+
+		std::vector<double> variables;
+		ClauseDatabase database;
+		generateSSAT(options, &variables, &database);
+		return writeSSATFile(argv[2], variables, database);
+	}
+
+	if (argc >= 2 && std::string(argv[1]).compare("sweep") == 0)
+		return runSweep(argc, argv);
+
+	// "batch [manifest or directory] [solution types] [options]" solves many instances in one process
+	if (argc >= 4 && std::string(argv[1]).compare("batch") == 0)
+		return runBatch(argc, argv);
+
+	// "evaluate [circuit] [probabilities]" re-evaluates a circuit written by --circuit for other chance probabilities
+	if (argc >= 3 && std::string(argv[1]).compare("evaluate") == 0)
+		return runEvaluate(argc, argv);
+
+	// Command line arguments
+    if (argc < 3) {
+		std::cout << "Invalid Arguments (" << argc << "). Need [directions] [filetype] [options] -- Exiting." << std::endl;
+		return 1;
+    }
+
+    // Argument 1 determines the heuristic and solution-type method to adjust DPLL options
+    SolutionType directions;
+    if (!parseDirections(argv[1], &directions)) {
+		std::cout << "---" << argv[1] << "---" << std::endl;
+		std::cout << "Incorrect solving directions. Exiting." << std::endl;
+		return 1;
+    }
+
+    // the instantiation of solve() for those directions, picked once for the whole run
+    SolveFunction solveFormula = solverFor(directions);
+
+    std::string fileName = std::string(argv[2]);
+
+    // Any further arguments are options
+    // --cache-mb N -- remember residual formula probabilities in a cache of at most N megabytes (0, the default, is no cache)
+    // --components -- solve variable-disjoint parts of the residual formula separately
+    // --threads N -- explore the two branches of a split on a pool of N threads (1, the default, is no pool)
+    // --spawn-depth D -- only hand out splits in the top D decisions (defaults to enough for a few tasks per thread)
+    // --speedup -- also solve on a single thread first and report how much faster the pool was
+    // --prune -- skip choice branches that can no longer change the answer
+    // --threshold T -- only decide whether the probability is at least T, stopping as soon as that is known
+    // --progress S -- write a progress line every S seconds while solving (10 by default, 0 for none)
+    // --preprocess -- simplify the clauses before solving (see preprocessSSAT())
+    // --time-limit S -- stop after S seconds with bounds on the probability and the best choices so far (see AnytimeSearch)
+    // --node-limit N -- the same, after N nodes
+    // --learn N -- learn clauses from conflicts, keeping at most N of them (see learnClause())
+    // --circuit FILE -- record the search as a circuit and write it to FILE, for the evaluate command (see CircuitBuilder)
+    unsigned int cacheMB = 0;
+    bool components = false;
+    bool prune = false;
+    bool decide = false;
+    double threshold = 0.0;
+    int threads = 1;
+    int spawnDepth = -1;
+    bool speedup = false;
+    double progressInterval = 10.0;
+    bool preprocess = false;
+    double timeLimit = 0.0;
+    long long nodeLimit = 0;
+    int learnLimit = 0;
+    std::string circuitFile;
+
+    for (int a = 3; a < argc; a++) {
+		if (std::string(argv[a]).compare("--cache-mb") == 0 && a + 1 < argc)
+			cacheMB = atoi(argv[++a]);
+		else if (std::string(argv[a]).compare("--components") == 0)
+			components = true;
+		else if (std::string(argv[a]).compare("--threads") == 0 && a + 1 < argc)
+			threads = std::max(1, atoi(argv[++a]));
+		else if (std::string(argv[a]).compare("--spawn-depth") == 0 && a + 1 < argc)
+			spawnDepth = atoi(argv[++a]);
+		else if (std::string(argv[a]).compare("--speedup") == 0)
+			speedup = true;
+		else if (std::string(argv[a]).compare("--prune") == 0)
+			prune = true;
+		else if (std::string(argv[a]).compare("--threshold") == 0 && a + 1 < argc) {
+			decide = true;
+			threshold = atof(argv[++a]);
+		}
+		else if (std::string(argv[a]).compare("--progress") == 0 && a + 1 < argc)
+			progressInterval = atof(argv[++a]);
+		else if (std::string(argv[a]).compare("--preprocess") == 0)
+			preprocess = true;
+		else if (std::string(argv[a]).compare("--time-limit") == 0 && a + 1 < argc)
+			timeLimit = atof(argv[++a]);
+		else if (std::string(argv[a]).compare("--node-limit") == 0 && a + 1 < argc)
+			nodeLimit = atoll(argv[++a]);
+		else if (std::string(argv[a]).compare("--learn") == 0 && a + 1 < argc)
+			learnLimit = std::max(0, atoi(argv[++a]));
+		else if (std::string(argv[a]).compare("--circuit") == 0 && a + 1 < argc)
+			circuitFile = argv[++a];
+		else {
+			std::cout << "Unknown option " << argv[a] << ". Exiting." << std::endl;
+			return 1;
+		}
+    }
+
+    // The bounds of a budgeted search are only sound if every finished subtree's probability is exact, and only one search keeps them
+    bool budgeted = (timeLimit > 0.0 || nodeLimit > 0);
+    if (budgeted && (threads > 1 || prune || decide)) {
+		std::cout << "A time or node limit can't be combined with --threads, --prune or --threshold. Exiting." << std::endl;
+		return 1;
+    }
+
+    // Learning needs unit propagation and no components (see learnsClauses())
+    if (learnLimit > 0 && !learnsClauses(directions, components)) {
+		std::cout << "--learn needs a solution type with unit propagation, and can't be combined with --components. Exiting." << std::endl;
+		return 1;
+    }
+
+    // A circuit has to hold for any probabilities, so nothing may be cut off because of the ones in the file (and its memo
+    // takes the place of the cache)
+    if (!circuitFile.empty() && (threads > 1 || prune || decide || budgeted || cacheMB > 0)) {
+		std::cout << "--circuit can't be combined with --threads, --prune, --threshold, --cache-mb or a time or node limit. Exiting." << std::endl;
+		return 1;
+    }
+
+    // The thresholds handed to solve() (see there). For the exact probability nothing is too low or high enough, and to
+    // decide whether it is at least T, anything up to just below T is too low and anything from T up is high enough
+    double low = -INFINITY;
+    double high = INFINITY;
+    if (decide) {
+		low = threshold - DECISION_TOLERANCE;
+		high = threshold;
+    }
+
+    //Initialize data structures to hold variables and clauses
+
+    // Vector of all variables in order with their probabilities
+    // NOTE the value is the probability (-1 if choice variable)
+    // The variable itself is represented by the index + 1
+    std::vector<double> variables;
+
+    // All clauses and the clauses each literal appears in (see ClauseDatabase)
+    ClauseDatabase database;
+
+    // Read file in and assign values to variables and clauses
+    // If file could not be opened, return 1
+    if (readSSATFile(fileName, &variables, &database, &std::cout) == 1) {
+		return 1;
+    }
+
+    if (preprocess)
+		preprocessSSAT(variables, &database, &std::cout);
+
+    // A circuit is recorded from a search on even chances, so that no chance variable is settled by a probability of 0
+    // or 1 in the file, and keeps the probabilities of the file to be evaluated with
+    CircuitBuilder circuit;
+    std::vector<double> searchVariables = variables;
+    if (!circuitFile.empty()) {
+		initCircuit(&circuit, variables);
+		for (unsigned int v = 0; v < searchVariables.size(); v++) {
+			if (searchVariables[v] != -1)
+				searchVariables[v] = 0.5;
+		}
+    }
+
+    // The formula state shared by the whole search, which holds
+    //
+    // formula.assignments -- vector of variable assignments where:
+    // -1 is false
+    // 0 is unassigned
+    // 1 is true
+    //
+    // formula.clauseSats -- vector that shows whether each clause is satisfied where:
+    // -1 is unsatisfied
+    // 0 un unassigned
+    // 1 is satisfied
+    //
+    // formula.clauseLengths -- the number of literals in each clause that are not yet false
+    //
+    // formula.numSatisfied, activeOccurrences -- counts of satisfied clauses and of each literal's active occurrences
+    //
+    // formula.pureQueue -- literals that have become pure, checked by the pure literal rule
+    //
+    // formula.trail -- every change made to the above during the search, so it can be undone on backtrack
+    //
+    // formula.watched, watchLists, unitQueue -- the watched literal scheme used to find unit
+    // and conflicting clauses (see initWatches())
+    Formula formula;
+    initFormula(&formula, &database, variables.size());
+    initScores(&formula, &searchVariables, directions);
+
+    formula.components = components;
+    formula.prune = prune;
+    formula.learned.limit = learnLimit;
+    if (!circuitFile.empty())
+		formula.circuit = &circuit;
+
+    ComponentCache cache;
+    if (cacheMB > 0) {
+		initCache(&cache, cacheMB);
+		formula.cache = &cache;
+    }
+
+    // With a pool, time the single-threaded search first if asked, so there is something to compare against
+    double serialTime = 0.0;
+    if (threads > 1 && speedup) {
+		Formula serialFormula;
+		initFormula(&serialFormula, &database, variables.size());
+		initScores(&serialFormula, &variables, directions);
+		serialFormula.components = components;
+		serialFormula.prune = prune;
+		serialFormula.learned.limit = learnLimit;
+
+		ComponentCache serialCache;
+		if (cacheMB > 0) {
+			initCache(&serialCache, cacheMB);
+			serialFormula.cache = &serialCache;
+		}
+
+		std::cout << "Solving on a single thread first" << std::endl;
+		std::chrono::steady_clock::time_point serialStart = std::chrono::steady_clock::now();
+		solveFormula(&variables, &serialFormula, low, high);
+		serialTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - serialStart).count();
+    }
+
+    // The pool, with this thread as worker 0 and the rest started up here
+    SolverPool pool;
+    std::vector<std::thread> workers;
+
+    if (threads > 1) {
+		pool.numThreads = threads;
+		pool.spawnDepth = spawnDepth;
+		pool.cacheMB = cacheMB;
+		pool.queues.resize(threads);
+		pool.locks = std::vector<std::mutex>(threads);
+		pool.stop = false;
+		pool.spawned = 0;
+		pool.stolen = 0;
+
+		// by default, aim for about eight tasks per thread
+		if (pool.spawnDepth < 0) {
+			pool.spawnDepth = 3;
+			for (int t = 1; t < threads; t *= 2)
+				pool.spawnDepth++;
+		}
+
+		formula.pool = &pool;
+		for (int t = 1; t < threads; t++)
+			workers.push_back(std::thread(runWorker, &pool, t));
+    }
+
+    // Progress lines go to the error stream, so they don't get in the way of anything reading the results
+    ProgressReport progress;
+    if (progressInterval > 0.0) {
+		progress.interval = progressInterval;
+		progress.start = std::chrono::steady_clock::now();
+		progress.next = progress.start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(progressInterval));
+		progress.nodes = 0;
+		formula.progress = &progress;
+    }
+
+    // A budgeted search reports its bounds as they tighten, at most once a second (unless progress lines are off)
+    AnytimeSearch anytime;
+    if (budgeted) {
+		anytime.timeLimit = timeLimit;
+		anytime.nodeLimit = nodeLimit;
+		anytime.start = std::chrono::steady_clock::now();
+		anytime.nextReport = anytime.start;
+		anytime.reportInterval = progressInterval > 0.0 ? 1.0 : 0.0;
+		anytime.stopped = false;
+		anytime.timedOut = false;
+		anytime.leadingFrames = 0;
+		anytime.lower = 0.0;
+		anytime.upper = 1.0;
+		anytime.lowerTime = 0.0;
+		formula.anytime = &anytime;
+    }
+
+    //Start solving the SSAT Problem and time it (by the wall clock, since a pool runs on several CPUs at once)
+    std::cout << "Beginning to solve!" << std::endl;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double solutionProb = solveFormula(&searchVariables, &formula, low, high);
+    double solveTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // a recorded search only has the circuit to show for itself, which gives the probability once evaluated
+    if (formula.circuit != NULL) {
+		circuit.circuit.root = circuit.result;
+
+		std::vector<double> results;
+		evaluateCircuit(circuit.circuit, variables, 1, &results);
+		solutionProb = results[0];
+    }
+
+    if (threads > 1) {
+		pool.stop = true;
+		for (unsigned int t = 0; t < workers.size(); t++)
+			workers[t].join();
+    }
+
+    if (budgeted && anytime.stopped) {
+		std::cout << "Stopped at the " << (anytime.timedOut ? "time" : "node") << " limit: solution is between " << anytime.lower
+				  << " and " << anytime.upper << " (after " << solveTime << " seconds)" << std::endl;
+    }
+    else if (!decide)
+		std::cout << "Solution is: " << solutionProb << " (found in " << solveTime << " seconds)" << std::endl;
+    else if (solutionProb > low) {
+		std::cout << "Solution is at least " << threshold << ": yes, it is at least " << solutionProb
+				  << " (found in " << solveTime << " seconds)" << std::endl;
+    }
+    else {
+		std::cout << "Solution is at least " << threshold << ": no, it is at most " << solutionProb
+				  << " (found in " << solveTime << " seconds)" << std::endl;
+    }
+    std::cout << "Nodes visited: " << formula.stats.nodes << std::endl;
+
+    // the choices made before the first chance split on the way to the lower bound, which are a plan in themselves
+    if (budgeted) {
+		std::cout << "Best choices (reaching " << anytime.lower << " after " << anytime.lowerTime << " seconds):";
+		for (unsigned int i = 0; i < anytime.bestChoices.size(); i++)
+			std::cout << " " << anytime.bestChoices[i];
+		std::cout << std::endl;
+    }
+
+    if (threads > 1) {
+		std::cout << "Threads: " << threads << ", tasks spawned: " << pool.spawned << ", stolen: " << pool.stolen << std::endl;
+		if (speedup)
+			std::cout << "Speedup over 1 thread: " << serialTime / solveTime << " (" << serialTime << " seconds on 1 thread)" << std::endl;
+    }
+
+    if (formula.components)
+		std::cout << "Component splits: " << formula.stats.componentSplits << std::endl;
+
+    if (formula.prune) {
+		std::cout << "Pruned: " << formula.stats.boundCutoffs << " nodes cut off on entry, " << formula.stats.choiceCutoffs
+				  << " choice branches, " << formula.stats.chanceCutoffs << " chance branches" << std::endl;
+    }
+
+    if (formula.learned.limit > 0) {
+		std::cout << "Learned clauses: " << formula.stats.learnedClauses << ", deleted: " << formula.stats.learnedDeletions
+				  << ", kept: " << formula.learned.live << std::endl;
+    }
+
+    if (formula.circuit != NULL) {
+		std::cout << "Circuit: " << circuit.circuit.types.size() << " nodes, " << circuit.circuit.children.size()
+				  << " edges, " << circuit.reused << " reused" << std::endl;
+		if (writeCircuitFile(circuitFile, circuit.circuit) == 1)
+			return 1;
+    }
+
+    if (formula.cache != NULL) {
+		std::cout << "Cache hits: " << cache.hits << ", misses: " << cache.misses << ", evictions: " << cache.evictions
+				  << ", entries: " << cache.used << " of " << cache.entries.size() << std::endl;
+    }
+
+    // and every counter on one line, for scripts
+    std::cout << "Statistics: " << statsJson(formula.stats, formula.cache, solveTime) << std::endl;
+
+    // all done!
+    return 0;
+}
+
+//
+// Reads in a file with an ssat problem and fills the vector of variables and the clause database
+// NOTE the file is memory mapped and read twice in place, once to count the variables, clauses and literals and once
+// to fill them into arenas of exactly that size, so nothing is allocated per line
+// @param fileName -- the name of the file to be opened and extracted
+// @param variables -- a pointer to a vector that can be filled with variable probabilites
+// @param database -- a pointer to a clause database that is filled with the clauses, and then which clauses each literal appears in
+// @param log -- where progress and errors are written (ptr)
+int readSSATFile(std::string fileName,
+		 std::vector<double>* variables, 
+		 ClauseDatabase* database,
+		 std::ostream* log)
+{
+    *log << "Reading in " << fileName << std::endl;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat info;
+
+    //File could not be opened
+    if (fd < 0 || fstat(fd, &info) != 0) {
+		*log << "Failed to open file. Exiting." << std::endl;
+		if (fd >= 0)
+			close(fd);
+		return 1;
+    }
+
+    // an empty file can't be mapped, but there is nothing in it to read either
+    size_t size = info.st_size;
+    const char* data = NULL;
+
+    if (size > 0) {
+		void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) {
+			*log << "Failed to map file. Exiting." << std::endl;
+			close(fd);
+			return 1;
+		}
+
+		data = (const char*)mapped;
+		madvise(mapped, size, MADV_SEQUENTIAL);
+    }
+
+    // a compiled instance is loaded as it is
+    if (size >= sizeof(CompiledHeader) && memcmp(data, COMPILED_MAGIC, sizeof(COMPILED_MAGIC)) == 0) {
+		int result = readCompiledFile(data, size, variables, database, log);
+
+		munmap((void*)data, size);
+		close(fd);
+
+		double loadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (result == 0) {
+			*log << "Loaded " << variables->size() << " variables and " << database->numClauses() << " clauses from a compiled file ("
+				 << size / (1024.0 * 1024.0) << " MB in " << loadTime << " seconds)" << std::endl;
+		}
+		return result;
+    }
+
+    // otherwise count everything first
+    int numVars = 0;
+    int numClauses = 0;
+    int numLiterals = 0;
+    if (scanSSAT(data, data + size, false, variables, database, &numVars, &numClauses, &numLiterals, log) == 1) {
+		if (data != NULL)
+			munmap((void*)data, size);
+		close(fd);
+		return 1;
+    }
+
+    // then fill it in
+    variables->assign(numVars, 0.0);
+    database->literals.assign(numLiterals, 0);
+    database->clauseStart.assign(numClauses + 1, 0);
+    scanSSAT(data, data + size, true, variables, database, &numVars, &numClauses, &numLiterals, log);
+
+    if (data != NULL)
+		munmap((void*)data, size);
+    close(fd);
+
+    double parseTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double megabytes = size / (1024.0 * 1024.0);
+    *log << "Parsed " << numVars << " variables and " << numClauses << " clauses (" << megabytes << " MB in "
+		 << parseTime << " seconds, " << (parseTime > 0.0 ? megabytes / parseTime : 0.0) << " MB/s)" << std::endl;
+
+    buildOccurrences(database, variables->size());
+    buildBlocks(*variables, database);
+
+    return 0;
+}
+
+// Walks the lines of a mapped .ssat file. Variables are the lines after a "variables" line, up to the next empty line,
+// each a variable name (1, 2, ... in order) and its probability, -1 for a choice variable.
+// Clauses are the lines after a "clauses" line, up to the next empty line, each a list of literals ended by 0.
+// Anything else in the file (solutions, timings) is skipped
+// @param data, end -- the mapped file
+// @param fill -- false to only count, true to write into variables and database, which must already be sized by the count
+// @param variables -- a pointer to the vector of variable probabilities
+// @param database -- a pointer to the clause database (literals and clauseStart)
+// NOTE the counting pass also checks what the filling pass relies on: that the variables are numbered in order and every
+// literal is of one of them (nothing indexes by literal without checking otherwise, see buildOccurrences()). It returns 1
+// after writing the first problem to log, and the filling pass always returns 0
+// @param numVars, numClauses, numLiterals -- set to the numbers of variables, clauses and literals in the file
+// @param log -- where a malformed line is reported (ptr)
+int scanSSAT(const char* data,
+		 const char* end,
+		 bool fill,
+		 std::vector<double>* variables,
+		 ClauseDatabase* database,
+		 int* numVars,
+		 int* numClauses,
+		 int* numLiterals,
+		 std::ostream* log)
+{
+	enum { noSection, variableSection, clauseSection } section = noSection;
+	int vars = 0;
+	int clauses = 0;
+	int literals = 0;
+	int largest = 0;
+	int largestLine = 0;
+	int lineNumber = 0;
+
+	const char* line = data;
+	while (line < end) {
+		lineNumber++;
+		const char* eol = (const char*)memchr(line, '\n', end - line);
+		if (eol == NULL)
+			eol = end;
+
+		const char* lineEnd = eol;
+		if (lineEnd > line && lineEnd[-1] == '\r')
+			lineEnd--;
+
+		const char* p = line;
+		line = eol + 1;
+
+		if (p == lineEnd) {						// an empty line ends a section
+			section = noSection;
+			continue;
+		}
+
+		if (section == noSection) {
+			if (lineEnd - p == 9 && memcmp(p, "variables", 9) == 0)
+				section = variableSection;
+			else if (lineEnd - p == 7 && memcmp(p, "clauses", 7) == 0)
+				section = clauseSection;
+			continue;
+		}
+
+		if (section == variableSection) {
+			int varName = 0;
+			double varValue = 0.0;
+
+			if (scanInt(&p, lineEnd, &varName))
+				scanDouble(&p, lineEnd, &varValue);
+
+			if (!fill && varName != vars + 1) {
+				*log << "Line " << lineNumber << " should declare variable " << vars + 1 << " (the variables have to be numbered"
+					 << " in order from 1). Exiting." << std::endl;
+				return 1;
+			}
+
+			if (fill)
+				(*variables)[vars] = varValue;
+			vars++;
+			continue;
+		}
+
+		// a clause line, up to its 0
+		int literal;
+		while (scanInt(&p, lineEnd, &literal) && literal != 0) {
+			if (fill)
+				database->literals[literals] = makeLiteral(abs(literal) - 1, literal < 0);
+			else if (abs(literal) > largest) {
+				largest = abs(literal);
+				largestLine = lineNumber;
+			}
+			literals++;
+		}
+
+		clauses++;
+		if (fill)
+			database->clauseStart[clauses] = literals;
+	}
+
+	// a literal of a variable that was never declared would land outside every per-literal array
+	if (!fill && largest > vars) {
+		*log << "Line " << largestLine << " has a literal of variable " << largest << ", but there are only " << vars
+			 << " variables. Exiting." << std::endl;
+		return 1;
+	}
+
+	*numVars = vars;
+	*numClauses = clauses;
+	*numLiterals = literals;
+	return 0;
+}
+
+// Reads an integer (with an optional sign) after any spaces or tabs
+// @param p -- the position to read from, moved past the integer (ptr)
+// @param end -- the end of the line
+// @param value -- filled in with the integer (ptr)
+bool scanInt(const char** p, const char* end, int* value)
+{
+	const char* c = *p;
+	while (c < end && (*c == ' ' || *c == '\t'))
+		c++;
+
+	bool negative = false;
+	if (c < end && (*c == '-' || *c == '+')) {
+		negative = (*c == '-');
+		c++;
+	}
+
+	if (c == end || *c < '0' || *c > '9')
+		return false;
+
+	// a number too big for an int reads as INT_MAX, which is out of range wherever it is used
+	int result = 0;
+	while (c < end && *c >= '0' && *c <= '9') {
+		int digit = *c++ - '0';
+		result = (result > (INT_MAX - digit) / 10) ? INT_MAX : result * 10 + digit;
+	}
+
+	*value = negative ? -result : result;
+	*p = c;
+	return true;
+}
+
+// Reads a decimal number (with an optional sign, fraction and exponent) after any spaces or tabs
+// NOTE a number of at most 15 significant digits and a small exponent, which covers every probability the generator
+// writes, is built from its digits and one exact power of ten, so a single rounding gives the same double strtod()
+// would. Anything else is handed to strtod() through a small copy, since the mapped file isn't NUL terminated
+// @param p -- the position to read from, moved past the number (ptr)
+// @param end -- the end of the line
+// @param value -- filled in with the number (ptr)
+bool scanDouble(const char** p, const char* end, double* value)
+{
+	static const double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+										  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	const char* c = *p;
+	while (c < end && (*c == ' ' || *c == '\t'))
+		c++;
+
+	const char* start = c;
+	bool negative = false;
+	if (c < end && (*c == '-' || *c == '+')) {
+		negative = (*c == '-');
+		c++;
+	}
+
+	// the digits, as one integer and the power of ten it is off by
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool anyDigits = false;
+
+	for (; c < end && *c >= '0' && *c <= '9'; c++) {
+		anyDigits = true;
+		if (mantissa == 0 && *c == '0')
+			continue;
+		if (digits < 19)
+			mantissa = mantissa * 10 + (*c - '0');
+		else
+			exponent++;
+		digits++;
+	}
+
+	if (c < end && *c == '.') {
+		for (c++; c < end && *c >= '0' && *c <= '9'; c++) {
+			anyDigits = true;
+			if (mantissa == 0 && *c == '0') {
+				exponent--;
+				continue;
+			}
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*c - '0');
+				exponent--;
+			}
+			digits++;
+		}
+	}
+
+	if (!anyDigits)
+		return false;
+
+	if (c < end && (*c == 'e' || *c == 'E')) {
+		int power;
+		const char* e = c + 1;
+		if (e < end && *e != ' ' && *e != '\t' && scanInt(&e, end, &power)) {
+			exponent += power;
+			c = e;
+		}
+	}
+
+	*p = c;
+
+	if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+		double result = (double)mantissa;
+		result = (exponent < 0) ? result / powersOfTen[-exponent] : result * powersOfTen[exponent];
+		*value = negative ? -result : result;
+		return true;
+	}
+
+	char buffer[64];
+	size_t length = std::min((size_t)(c - start), sizeof(buffer) - 1);
+	memcpy(buffer, start, length);
+	buffer[length] = '\0';
+	*value = strtod(buffer, NULL);
+	return true;
+}
+
+// Fills in the occurrence lists with a counting pass, so every list lands in one arena with no per-list allocation
+// NOTE every literal has to be of one of the numVars variables, which the readers check before calling this
+// @param database -- a pointer to a clause database whose literals and clauseStart are already filled
+// @param numVars -- the number of variables in the formula
+void buildOccurrences(ClauseDatabase* database, int numVars)
+{
+	// count the appearances of each literal, shifted by one so the running sum gives each literal's start
+	database->occurrenceStart.assign(2 * numVars + 1, 0);
+	for (unsigned int i = 0; i < database->literals.size(); i++)
+		database->occurrenceStart[database->literals[i] + 1]++;
+
+	for (int l = 0; l < 2 * numVars; l++)
+		database->occurrenceStart[l + 1] += database->occurrenceStart[l];
+
+	// then drop every clause into the next free slot of each of its literals
+	std::vector<int> next(database->occurrenceStart.begin(), database->occurrenceStart.end() - 1);
+	database->occurrences.assign(database->literals.size(), 0);
+
+	for (int c = 0; c < database->numClauses(); c++) {
+		for (int i = database->clauseStart[c]; i < database->clauseStart[c + 1]; i++)
+			database->occurrences[next[database->literals[i]]++] = c;
+	}
+}
+
+// Finds the quantifier blocks of the prefix, where a new block starts wherever a choice variable follows a chance one or
+// the other way around
+// @param variables -- the variable probabilities (-1 for choice variables)
+// @param database -- a pointer to the clause database whose blockStart is filled in
+void buildBlocks(const std::vector<double>& variables, ClauseDatabase* database)
+{
+	database->blockStart.clear();
+
+	for (unsigned int v = 0; v < variables.size(); v++) {
+		if (v == 0 || (variables[v] == -1) != (variables[v - 1] == -1))
+			database->blockStart.push_back(v);
+	}
+
+	database->blockStart.push_back(variables.size());
+	buildBlockIndex(database);
+}
+
+// Fills in blockOf from blockStart (a compiled file only stores the latter)
+// @param database -- a pointer to the clause database whose blockOf is filled in
+void buildBlockIndex(ClauseDatabase* database)
+{
+	int numBlocks = database->blockStart.size() - 1;
+
+	database->blockOf.resize(database->blockStart[numBlocks]);
+	for (int b = 0; b < numBlocks; b++) {
+		for (int v = database->blockStart[b]; v < database->blockStart[b + 1]; v++)
+			database->blockOf[v] = b;
+	}
+}
+
+// Loads a compiled instance (see writeCompiledFile()) after checking its version, its size and its checksum. Every array
+// is already laid out as it is in memory, so each one is a single copy out of the mapped file
+// @param data, size -- the mapped file, which starts with COMPILED_MAGIC
+// @param variables -- a pointer to the vector of variable probabilities to fill
+// @param database -- a pointer to the clause database to fill, occurrence lists and blocks included
+// @param log -- where errors are written (ptr)
+int readCompiledFile(const char* data,
+		 size_t size,
+		 std::vector<double>* variables,
+		 ClauseDatabase* database,
+		 std::ostream* log)
+{
+	CompiledHeader header;
+	memcpy(&header, data, sizeof(header));
+
+	if (header.version != COMPILED_VERSION) {
+		*log << "Compiled file has version " << header.version << ", expected " << COMPILED_VERSION
+			 << " (compile it again). Exiting." << std::endl;
+		return 1;
+	}
+
+	unsigned long long numVars = header.numVars;
+	unsigned long long numInts = (header.numClauses + 1ULL) + header.numLiterals + (2 * numVars + 1)
+								 + header.numLiterals + (header.numBlocks + 1ULL);
+	unsigned long long expected = sizeof(CompiledHeader) + numVars * sizeof(double) + numInts * sizeof(int);
+
+	if (size != expected) {
+		*log << "Compiled file is " << size << " bytes, expected " << expected << ". Exiting." << std::endl;
+		return 1;
+	}
+
+	const char* payload = data + sizeof(CompiledHeader);
+	if (compiledChecksum(payload, size - sizeof(CompiledHeader)) != header.checksum) {
+		*log << "Compiled file failed its checksum. Exiting." << std::endl;
+		return 1;
+	}
+
+	variables->resize(numVars);
+	memcpy(variables->data(), payload, numVars * sizeof(double));
+	payload += numVars * sizeof(double);
+
+	std::vector<int>* arrays[] = { &database->clauseStart, &database->literals, &database->occurrenceStart,
+								   &database->occurrences, &database->blockStart };
+	unsigned long long lengths[] = { header.numClauses + 1ULL, header.numLiterals, 2 * numVars + 1,
+									 header.numLiterals, header.numBlocks + 1ULL };
+
+	for (int a = 0; a < 5; a++) {
+		arrays[a]->resize(lengths[a]);
+		memcpy(arrays[a]->data(), payload, lengths[a] * sizeof(int));
+		payload += lengths[a] * sizeof(int);
+	}
+
+	// the solver trusts every index, so a file that passed its checksum still has to make sense
+	if (!validCompiledArrays(numVars, *database)) {
+		*log << "Compiled file has a malformed clause, occurrence list or block. Exiting." << std::endl;
+		return 1;
+	}
+	buildBlockIndex(database);
+
+	return 0;
+}
+
+// Checks that the arrays of a compiled instance point where they should: clause and occurrence list starts that run
+// from 0 up to the number of literals, literals of the instance's variables, occurrences of its clauses, and block
+// starts that run from 0 up to the number of variables
+// @param numVars -- the number of variables
+// @param database -- the clause database as read in, before its blocks are indexed
+bool validCompiledArrays(unsigned long long numVars, const ClauseDatabase& database)
+{
+	const std::vector<int>* starts[] = { &database.clauseStart, &database.occurrenceStart, &database.blockStart };
+	unsigned long long ends[] = { database.literals.size(), database.occurrences.size(), numVars };
+
+	for (int a = 0; a < 3; a++) {
+		const std::vector<int>& start = *starts[a];
+		if (start.front() != 0 || (unsigned long long)start.back() != ends[a])
+			return false;
+
+		for (unsigned int i = 1; i < start.size(); i++) {
+			if (start[i] < start[i - 1] || (a == 2 && start[i] == start[i - 1]))
+				return false;
+		}
+	}
+
+	for (unsigned int i = 0; i < database.literals.size(); i++) {
+		if (database.literals[i] < 0 || (unsigned long long)database.literals[i] >= 2 * numVars)
+			return false;
+	}
+
+	for (unsigned int i = 0; i < database.occurrences.size(); i++) {
+		if (database.occurrences[i] < 0 || database.occurrences[i] >= database.numClauses())
+			return false;
+	}
+
+	return true;
+}
+
+// Writes a compiled instance: a CompiledHeader followed by the variable probabilities and every array of the clause
+// database, occurrence lists and blocks included, exactly as they are in memory (so it only loads on the same kind of machine)
+// @param fileName -- the name of the file to write
+// @param variables -- the variable probabilities
+// @param database -- the clause database, with its occurrence lists and blocks built
+int writeCompiledFile(std::string fileName,
+		 const std::vector<double>& variables,
+		 const ClauseDatabase& database)
+{
+	std::vector<char> payload;
+	const std::vector<int>* arrays[] = { &database.clauseStart, &database.literals, &database.occurrenceStart,
+										 &database.occurrences, &database.blockStart };
+
+	payload.insert(payload.end(), (const char*)variables.data(), (const char*)(variables.data() + variables.size()));
+	for (int a = 0; a < 5; a++)
+		payload.insert(payload.end(), (const char*)arrays[a]->data(), (const char*)(arrays[a]->data() + arrays[a]->size()));
+
+	CompiledHeader header;
+	memcpy(header.magic, COMPILED_MAGIC, sizeof(COMPILED_MAGIC));
+	header.version = COMPILED_VERSION;
+	header.numVars = variables.size();
+	header.numClauses = database.numClauses();
+	header.numLiterals = database.literals.size();
+	header.numBlocks = database.blockStart.size() - 1;
+	header.reserved = 0;
+	header.checksum = compiledChecksum(payload.data(), payload.size());
+
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file) {
+		std::cout << "Failed to open " << fileName << " for writing. Exiting." << std::endl;
+		return 1;
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	file.write(payload.data(), payload.size());
+
+	if (!file) {
+		std::cout << "Failed to write " << fileName << ". Exiting." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Wrote " << fileName << " (" << (sizeof(header) + payload.size()) / (1024.0 * 1024.0) << " MB)" << std::endl;
+	return 0;
+}
+
+// Checksums memory eight bytes at a time (multiply and xor-shift on each word, then the leftover bytes), which is
+// enough to catch a truncated or corrupted compiled file without costing much next to the copy
+// @param data, size -- the memory to checksum
+unsigned long long compiledChecksum(const char* data, size_t size)
+{
+	unsigned long long h = 0x9e3779b97f4a7c15ULL ^ size;
+	size_t i = 0;
+
+	for (; i + 8 <= size; i += 8) {
+		unsigned long long word;
+		memcpy(&word, data + i, 8);
+		h = (h ^ word) * 0xbf58476d1ce4e5b9ULL;
+		h ^= h >> 29;
+	}
+
+	for (; i < size; i++)
+		h = (h ^ (unsigned char)data[i]) * 0x94d049bb133111ebULL;
+
+	return h ^ (h >> 32);
+}
+
+// Simplifies the clauses of an instance in three passes, each of which leaves the clauses true under exactly the same
+// assignments of the variables. The probability of an SSAT instance only depends on its prefix and on which assignments
+// satisfy its clauses, so that makes every pass sound whatever the quantifier of each variable:
+// 1. duplicate literals are dropped from each clause, clauses with both literals of a variable (always true) and clauses
+//	  that appear more than once are removed
+// 2. a clause that another contains is removed (subsumption), and a clause that contains another except for one
+//	  flipped literal loses that literal (strengthening, since resolving the two gives the shorter clause, which
+//	  then subsumes it). Shorter clauses are tried first and a strengthened clause is tried again
+// 3. unit clauses are propagated, and then each literal of every unassigned choice variable is tried in turn. If
+//	  propagating it fails (a failed literal) every satisfying assignment has it false, so its negation is added
+//	  as a unit clause and propagated. At the end every assigned literal is kept as a unit clause (so a chance
+//	  variable's probability is still counted by the search), satisfied clauses are removed and false literals dropped
+// The quantifier blocks and the variables stay as they are, so a variable may end up in no clause at all
+// @param variables -- the variable probabilities (-1 for choice variables)
+// @param database -- a pointer to the clause database, which is rebuilt from the simplified clauses
+// @param log -- where the report of each pass goes (ptr)
+void preprocessSSAT(const std::vector<double>& variables, ClauseDatabase* database, std::ostream* log)
+{
+	int numVars = variables.size();
+	int clausesBefore = database->numClauses();
+	int literalsBefore = database->literals.size();
+
+	std::vector<std::vector<int>> clauses(database->numClauses());
+	for (int c = 0; c < database->numClauses(); c++)
+		clauses[c].assign(database->literals.begin() + database->clauseStart[c], database->literals.begin() + database->clauseStart[c + 1]);
+
+	// 1. duplicates and tautologies
+	double passStart = phaseClock();
+	int tautologies = 0;
+	int duplicates = 0;
+	std::vector<char> removed(clauses.size(), 0);
+
+	for (unsigned int c = 0; c < clauses.size(); c++) {
+		std::vector<int>& clause = clauses[c];
+		std::sort(clause.begin(), clause.end());
+		clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+
+		// the two literals of a variable sort next to each other
+		for (unsigned int i = 1; i < clause.size() && !removed[c]; i++) {
+			if (literalVar(clause[i]) == literalVar(clause[i - 1])) {
+				removed[c] = 1;
+				tautologies++;
+			}
+		}
+	}
+
+	// sorting the clauses brings equal ones together, and the first of each (the sort is stable) is kept
+	std::vector<int> order;
+	for (unsigned int c = 0; c < clauses.size(); c++) {
+		if (!removed[c])
+			order.push_back(c);
+	}
+	std::stable_sort(order.begin(), order.end(), [&clauses](int a, int b) { return clauses[a] < clauses[b]; });
+	for (unsigned int i = 1; i < order.size(); i++) {
+		if (clauses[order[i]] == clauses[order[i - 1]]) {
+			removed[order[i]] = 1;
+			duplicates++;
+		}
+	}
+
+	*log << "Preprocessing: removed " << duplicates << " duplicate clauses and " << tautologies << " tautologies ("
+		 << phaseClock() - passStart << " seconds)" << std::endl;
+
+	// 2. subsumption and strengthening
+	passStart = phaseClock();
+	int subsumed = 0;
+	int strengthened = 0;
+	std::vector<std::vector<int>> occurrences(2 * numVars);
+	std::vector<unsigned long long> signatures(clauses.size());
+	std::vector<char> queued(clauses.size(), 0);
+	std::deque<int> queue;
+
+	for (unsigned int c = 0; c < clauses.size(); c++) {
+		if (removed[c])
+			continue;
+
+		for (unsigned int i = 0; i < clauses[c].size(); i++)
+			occurrences[clauses[c][i]].push_back(c);
+		signatures[c] = clauseSignature(clauses[c]);
+	}
+
+	order.clear();
+	for (unsigned int c = 0; c < clauses.size(); c++) {
+		if (!removed[c])
+			order.push_back(c);
+	}
+	std::stable_sort(order.begin(), order.end(), [&clauses](int a, int b) { return clauses[a].size() < clauses[b].size(); });
+	for (unsigned int i = 0; i < order.size(); i++) {
+		queue.push_back(order[i]);
+		queued[order[i]] = 1;
+	}
+
+	while (!queue.empty()) {
+		int c = queue.front();
+		queue.pop_front();
+		queued[c] = 0;
+
+		if (removed[c] || clauses[c].empty())
+			continue;
+
+		// every clause c could subsume or strengthen has its rarest variable, with either sign
+		int rarest = clauses[c][0];
+		for (unsigned int i = 1; i < clauses[c].size(); i++) {
+			int v = literalVar(clauses[c][i]);
+			if (occurrences[2*v].size() + occurrences[2*v + 1].size()
+				< occurrences[2*literalVar(rarest)].size() + occurrences[2*literalVar(rarest) + 1].size())
+				rarest = clauses[c][i];
+		}
+
+		// NOTE the signature a flipped literal of c would have in d is the same, since it is made from variables
+		unsigned long long signature = signatures[c];
+		for (int sign = 0; sign < 2; sign++) {
+			// NOTE a strengthened clause stays on the lists of the literal it lost, which subsumeLiteral() simply fails on
+			const std::vector<int>& candidates = occurrences[2*literalVar(rarest) + sign];
+
+			for (unsigned int k = 0; k < candidates.size() && !removed[c]; k++) {
+				int d = candidates[k];
+
+				// the signatures rule out nearly every candidate, without touching the clause itself
+				if ((signature & ~signatures[d]) != 0 || d == c || removed[d] || clauses[d].size() < clauses[c].size())
+					continue;
+
+				int flipped = subsumeLiteral(clauses[c], clauses[d]);
+				if (flipped == -2)
+					continue;
+
+				if (flipped == -1) {
+					removed[d] = 1;
+					subsumed++;
+					continue;
+				}
+
+				std::vector<int>& clause = clauses[d];
+				clause.erase(std::find(clause.begin(), clause.end(), negateLiteral(flipped)));
+				signatures[d] = clauseSignature(clause);
+				strengthened++;
+
+				if (!queued[d]) {
+					queue.push_back(d);
+					queued[d] = 1;
+				}
+			}
+		}
+	}
+
+	*log << "Preprocessing: removed " << subsumed << " subsumed clauses and " << strengthened << " literals by strengthening ("
+		 << phaseClock() - passStart << " seconds)" << std::endl;
+
+	// 3. unit propagation and failed literals, on a formula over what is left
+	passStart = phaseClock();
+	ClauseDatabase reduced;
+	reduced.clauseStart.assign(1, 0);
+	for (unsigned int c = 0; c < clauses.size(); c++) {
+		if (removed[c])
+			continue;
+
+		reduced.literals.insert(reduced.literals.end(), clauses[c].begin(), clauses[c].end());
+		reduced.clauseStart.push_back(reduced.literals.size());
+	}
+	buildOccurrences(&reduced, numVars);
+	buildBlocks(variables, &reduced);
+
+	Formula formula;
+	initFormula(&formula, &reduced, numVars);
+
+	int failedLiterals = 0;
+	bool consistent = propagateUnits(&formula, NULL, NULL);
+
+	for (int v = 0; v < numVars && consistent; v++) {
+		if (variables[v] != -1)
+			continue;
+
+		for (int sign = 0; sign < 2 && consistent && formula.assignments[v] == 0; sign++) {
+			unsigned int trailMark = formula.trail.size();
+			int value = (sign == 0) ? 1 : -1;
+
+			assignVariable(v, value, &formula);
+			satisfyClauses(v, &formula);
+			bool failed = !propagateUnits(&formula, NULL, NULL);
+			undoTrail(&formula, trailMark);
+
+			if (failed) {
+				failedLiterals++;
+				assignVariable(v, -value, &formula);
+				satisfyClauses(v, &formula);
+				consistent = propagateUnits(&formula, NULL, NULL);
+			}
+		}
+	}
+
+	// the simplified clauses: a unit clause per assigned variable, then what is left of every unsatisfied clause
+	// (or a single empty clause if the clauses can't be satisfied at all)
+	database->literals.clear();
+	database->clauseStart.assign(1, 0);
+
+	if (consistent) {
+		for (int v = 0; v < numVars; v++) {
+			if (formula.assignments[v] == 0)
+				continue;
+
+			database->literals.push_back(makeLiteral(v, formula.assignments[v] == -1));
+			database->clauseStart.push_back(database->literals.size());
+		}
+
+		for (int c = 0; c < reduced.numClauses(); c++) {
+			if (formula.clauseSats[c] == 1)
+				continue;
+
+			for (int i = reduced.clauseStart[c]; i < reduced.clauseStart[c + 1]; i++) {
+				if (literalValue(reduced.literals[i], formula.assignments) == 0)
+					database->literals.push_back(reduced.literals[i]);
+			}
+			database->clauseStart.push_back(database->literals.size());
+		}
+	}
+	else
+		database->clauseStart.push_back(0);
+
+	buildOccurrences(database, numVars);
+	buildBlocks(variables, database);
+
+	*log << "Preprocessing: found " << failedLiterals << " failed literals, with " << formula.numAssigned
+		 << " variables fixed in all" << (consistent ? "" : " before the clauses turned out unsatisfiable") << " ("
+		 << phaseClock() - passStart << " seconds)" << std::endl;
+	*log << "Preprocessed " << clausesBefore << " clauses and " << literalsBefore << " literals down to "
+		 << database->numClauses() << " clauses and " << database->literals.size() << " literals" << std::endl;
+}
+
+// Checks whether clause c subsumes clause d (every literal of c is in d), or would if one literal of c were flipped,
+// in which case d can lose the flipped literal's negation. Both clauses are sorted, so one walk through them does
+// @param c -- the shorter clause
+// @param d -- the longer clause
+// Returns -1 if c subsumes d, the literal of c whose negation is in d if only that one is flipped, or -2 otherwise
+int subsumeLiteral(const std::vector<int>& c, const std::vector<int>& d)
+{
+	int flipped = -1;
+	unsigned int j = 0;
+
+	for (unsigned int i = 0; i < c.size(); i++) {
+		while (j < d.size() && literalVar(d[j]) < literalVar(c[i]))
+			j++;
+
+		if (j == d.size() || literalVar(d[j]) != literalVar(c[i]))
+			return -2;
+
+		if (d[j] != c[i]) {
+			if (flipped != -1)
+				return -2;
+			flipped = c[i];
+		}
+		j++;
+	}
+
+	return flipped;
+}
+
+// Sets a bit for every variable of a clause (modulo 64), so c can only subsume d when c's bits are all set in d's
+// @param clause -- the clause
+unsigned long long clauseSignature(const std::vector<int>& clause)
+{
+	unsigned long long signature = 0;
+
+	for (unsigned int i = 0; i < clause.size(); i++)
+		signature |= 1ULL << (literalVar(clause[i]) & 63);
+
+	return signature;
+}
+
+// Assigns the literal of every queued unit clause and propagates it, including the units that turn up on the way,
+// until the queue is empty or a clause has every literal false. A unit chance variable takes the value its clause
+// needs, so with weight the chance of each such value is multiplied in (a unit choice variable has a chance of 1),
+// and propagation stops early if that comes to 0
+// NOTE every change goes on the trail, so undoTrail() takes back the whole propagation
+// @param formula -- the formula to propagate in (ptr)
+// @param variables -- a pointer to a vector of variables' probabilities, or NULL without weight
+// @param weight -- multiplied by the chance of every assigned chance literal (ptr, or NULL)
+// Returns false if there is a conflict
+bool propagateUnits(Formula* formula, const std::vector<double>* variables, double* weight)
+{
+	while (!formula->conflict) {
+		int unitLiteral = nextUnit(formula);
+		if (unitLiteral == -1)
+			break;
+
+		int unitVar = literalVar(unitLiteral);
+		if (weight != NULL && variables->at(unitVar) != -1) {
+			*weight *= literalNegative(unitLiteral) ? 1 - variables->at(unitVar) : variables->at(unitVar);
+			if (*weight == 0.0)
+				break;
+		}
+
+		formula->stats.unitPropagations++;
+		assignVariable(unitVar, literalNegative(unitLiteral) ? -1 : 1, formula);
+		formula->reasons[unitVar] = formula->unitReasons[formula->unitHead];
+		satisfyClauses(unitVar, formula);
+	}
+
+	return !formula->conflict;
+}
+
+// Sets up the formula state for a search over the given clauses, with every variable unassigned and
+// every clause unsatisfied, and watches two literals of every clause
+// @param formula -- a pointer to the formula state to set up
+// @param database -- the clauses to search over, which must outlive the formula
+// @param numVars -- the number of variables in the formula
+void initFormula(Formula* formula, const ClauseDatabase* database, int numVars)
+{
+	formula->database = database;
+
+    // Fill assignments such that each variable has an unassigned value
+	formula->assignments.assign(numVars, 0);
+
+    // Fill clauseSats such that each clause is unassigned a satisfaction value
+	formula->clauseSats.assign(database->numClauses(), 0);
+	formula->clauseLengths.resize(database->numClauses());
+	for (int c = 0; c < database->numClauses(); c++)
+		formula->clauseLengths[c] = database->clauseLength(c);
+
+	formula->numSatisfied = 0;
+	formula->trail.clear();
+	formula->residualHash[0] = 0;
+	formula->residualHash[1] = 0;
+	formula->cache = NULL;
+	formula->stats = SolveStats();
+	formula->numAssigned = 0;
+	formula->progress = NULL;
+	formula->anytime = NULL;
+	formula->circuit = NULL;
+	formula->prune = false;
+
+	formula->searchStack.resize(numVars + 1);
+	formula->searchDepth = 0;
+	formula->componentClauses.clear();
+	formula->componentStarts.clear();
+
+	formula->components = false;
+	formula->varMarks.assign(numVars, 0);
+	formula->clauseMarks.assign(database->numClauses(), 0);
+	formula->componentStamp = 0;
+
+	formula->pool = NULL;
+	formula->worker = 0;
+	formula->decisionDepth = 0;
+
+    // No learned clauses until the limit is raised
+	formula->learned = LearnedClauses();
+	formula->learned.limit = 0;
+	formula->learned.live = 0;
+	formula->learned.garbage = 0;
+	formula->learned.bump = 1.0;
+	formula->learned.pending = -1;
+	formula->reasons.assign(numVars, -1);
+	formula->assignedAt.assign(numVars, 0);
+	formula->seen.assign(numVars, 0);
+	formula->seenVars.clear();
+	formula->learnedClause.clear();
+
+    // Every variable of every block starts out unassigned
+	formula->blockVars.resize(numVars);
+	formula->blockPositions.resize(numVars);
+	for (int v = 0; v < numVars; v++) {
+		formula->blockVars[v] = v;
+		formula->blockPositions[v] = v;
+	}
+	formula->blockFree.resize(database->blockStart.size() - 1);
+	for (unsigned int b = 0; b + 1 < database->blockStart.size(); b++)
+		formula->blockFree[b] = database->blockStart[b + 1] - database->blockStart[b];
+
+    // No scores until a heuristic asks for them
+	formula->scores = ScoreHeap();
+	formula->scores.score = NULL;
+
+    // Every occurrence starts out active, and every literal whose negation doesn't occur at all is pure from the start
+	formula->activeOccurrences.resize(2*numVars);
+	formula->pureQueue.clear();
+	formula->pureHead = 0;
+	for (int literal = 0; literal < 2*numVars; literal++) {
+		formula->activeOccurrences[literal] = database->occurrenceStart[literal + 1] - database->occurrenceStart[literal];
+		if (literalNegative(literal) && formula->activeOccurrences[literal - 1] == 0 && formula->activeOccurrences[literal] > 0)
+			formula->pureQueue.push_back(literal);
+		else if (literalNegative(literal) && formula->activeOccurrences[literal] == 0 && formula->activeOccurrences[literal - 1] > 0)
+			formula->pureQueue.push_back(literal - 1);
+	}
+
+    // Watch two literals of every clause
+	initWatches(formula);
+}
+
+// Solves the SSAT problem using a DPLL-style SAT solver
+// Returns the maximum probability of success that can be found in the SSAT encoding (and therefore the probability of success of the underlying plans)
+// NOTE low and high are the thresholds the caller cares about. A probability strictly between them is returned exactly,
+// one at or below low may come back as anything from the probability up to low (an upper bound that is still too low to
+// matter), and one at or above high as anything from high up to the probability (a lower bound that is already high
+// enough). -INFINITY and INFINITY always get the exact probability. Chance splits work out what each branch needs for the
+// node to clear its thresholds, and a choice split stops as soon as one branch clears high. With formula->prune, a choice
+// split's second branch also has to beat the first, so whole subtrees are cut off as soon as they can't change the result
+// NOTE Policy (a SolvePolicy) decides which rules run at each node, see solverFor()
+// NOTE with unit propagation, every unit clause is propagated here in one go (see propagateUnits()), so only decisions and
+// pure variables go a node deeper, and a unit chance variable scales the node's thresholds and result by the chance of its value
+// NOTE the search doesn't recurse. Starting a node (startNode()) or carrying on with a suspended step (resumeSearch())
+// either comes up with a probability, which goes to the step on top of formula->searchStack, or suspends the step
+// there and asks for a node deeper, and this loop runs them until the first node is done. So however deep the search
+// goes, the call stack stays where it is
+// NOTE with formula->circuit, every probability the search comes up with is also built as a circuit node, and the
+// residual formulas solved are remembered there instead of in the cache. Its search has to be the same for any chance
+// probabilities, so it gets infinite thresholds and chance probabilities strictly between 0 and 1 (see main()), unit
+// chance variables don't scale anything, and the probabilities it returns along the way mean nothing
+// @param variables -- a pointer to a vector of variables' probabilities
+// @param formula -- a pointer to the formula state (clauseSats, clauseLengths, assignments, ...) NOTE every change made
+//					 below this call is undone through the trail before it returns, so the caller sees the formula unchanged
+// @param low -- the probability the answer has to beat to matter to the caller
+// @param high -- the probability above which the caller doesn't need to know any more
+template <class Policy>
+double solve(std::vector<double>* variables,
+	     Formula* formula,
+	     double low,
+	     double high)
+{
+	unsigned int base = formula->searchDepth;
+	unsigned int trailMark = formula->trail.size();
+	double result = 0.0;
+
+	for (;;) {
+		// go deeper until a node is solved on the spot
+		while (startNode<Policy>(variables, formula, &low, &high, &result))
+			;
+
+		// then hand its probability back up until a step needs another node
+		do {
+			if (formula->searchDepth == base) {
+				undoTrail(formula, trailMark);
+				return result;
+			}
+		} while (!resumeSearch(formula, &low, &high, &result));
+	}
+}
+
+// Suspends a step of the search on top of formula->searchStack, growing it if the search has never been this deep
+// @param formula -- the formula being solved (ptr)
+// @param step -- where the step carries on
+// @return the frame, for the step to fill in
+inline SearchFrame* pushSearch(Formula* formula, SearchStep step)
+{
+	if (formula->searchDepth == formula->searchStack.size())
+		formula->searchStack.resize(2*formula->searchStack.size() + 1);
+
+	SearchFrame* frame = &formula->searchStack[formula->searchDepth++];
+	frame->step = step;
+	return frame;
+}
+
+// Starts a node of the search (see solve()): propagates its unit clauses, if Policy does
+// @param variables -- a pointer to a vector of variables' probabilities
+// @param formula -- a pointer to the formula state
+// @param low, high -- the thresholds the caller cares about (see solve()), scaled for whatever comes next
+// @param result -- set to the probability of the node, if this is as far as it goes
+// @return whether a node deeper has to be solved first, with low and high as its thresholds
+template <class Policy>
+bool startNode(std::vector<double>* variables, Formula* formula, double* low, double* high, double* result)
+{
+	// a budgeted search that has run out backs all the way out, leaving its bounds as they are
+	if (formula->anytime != NULL && !keepSearching(formula)) {
+		*result = 0.0;
+		return false;
+	}
+
+	formula->stats.nodes++;
+
+	if (formula->progress != NULL && (formula->stats.nodes & (PROGRESS_CHECK_NODES - 1)) == 0)
+		reportProgress(formula);
+
+	// the clause learned at the last conflict is usually unit by now, but nothing watching it has changed to say so
+	if (Policy::units && formula->learned.pending != -1)
+		assertLearned(formula);
+
+	//User wants solution to execute unit clause propogation, for as long as the watches keep finding unit clauses
+	if (Policy::units && formula->unitHead < formula->unitQueue.size()) {
+		unsigned int trailMark = formula->trail.size();
+		bool timed = (formula->stats.nodes & (TIMING_SAMPLE - 1)) == 0;
+		double phaseStart = timed ? phaseClock() : 0.0;
+
+		// the chance of the values the unit chance variables were given, which the remainder is scaled by
+		double weight = 1.0;
+		propagateUnits(formula, variables, formula->circuit == NULL ? &weight : NULL);
+		if (timed)
+			formula->stats.propagationTime += phaseClock() - phaseStart;
+
+		if (weight > 0.0) {
+			if (formula->anytime != NULL)
+				pushBoundFrame(formula, scaleFrame, weight);
+
+			SearchFrame* frame = pushSearch(formula, afterPropagated);
+			frame->trailMark = trailMark;
+			frame->weight = weight;
+
+			*low /= weight;
+			*high /= weight;
+			if (startPropagated<Policy>(variables, formula, low, high, result))
+				return true;
+
+			// solved on the spot, so there is no need to wait for resumeSearch()
+			formula->searchDepth--;
+			if (formula->anytime != NULL)
+				popBoundFrame(formula);
+			if (formula->circuit != NULL)
+				formula->circuit->result = scaledCircuitNode(formula, formula->circuit->result, trailMark);
+			undoTrail(formula, trailMark);
+
+			*result *= weight;
+			return false;
+		}
+
+		if (formula->anytime != NULL)
+			anytimeLeaf(variables, formula, 0.0);
+		undoTrail(formula, trailMark);
+
+		*result = 0.0;
+		return false;
+	}
+
+	return startPropagated<Policy>(variables, formula, low, high, result);
+}
+
+// The rest of a node, once there is nothing left to propagate: a conflict fails, a satisfied formula succeeds, thresholds
+// that settle the answer on their own cut the node off, and otherwise the residual formula is looked up in the cache or solved
+// @param variables -- a pointer to a vector of variables' probabilities
+// @param formula -- a pointer to the formula state
+// @param low, high -- the thresholds the caller cares about (see solve())
+// @param result -- set to the probability of the node, if this is as far as it goes
+// @return whether a node deeper has to be solved first, with low and high as its thresholds
+template <class Policy>
+bool startPropagated(std::vector<double>* variables, Formula* formula, double* low, double* high, double* result)
+{
+	formula->stats.maxDepth = std::max(formula->stats.maxDepth, formula->numAssigned);
+
+	// first, check if the watches found a clause with every literal false, in which case this branch of the plan fails
+	if (formula->conflict) {
+		formula->stats.conflicts++;
+		if (Policy::units && formula->learned.limit > 0)
+			learnClause(formula);
+		if (formula->anytime != NULL)
+			anytimeLeaf(variables, formula, 0.0);
+		if (formula->circuit != NULL)
+			formula->circuit->result = 0;
+		*result = 0.0;
+		return false;
+	}
+
+	// if every clause is satisfied, return success for this plan
+    if (formula->numSatisfied == formula->clauseSats.size()) {
+		if (formula->anytime != NULL)
+			anytimeLeaf(variables, formula, 1.0);
+		if (formula->circuit != NULL)
+			formula->circuit->result = 1;
+		*result = 1.0;
+		return false;
+    }
+
+    // nothing beats a low threshold of 1, and everything clears a high threshold of 0, so those are as good an answer as any
+    if (*low >= 1.0) {
+		formula->stats.boundCutoffs++;
+		*result = 1.0;
+		return false;
+    }
+    if (*high <= 0.0) {
+		formula->stats.boundCutoffs++;
+		*result = 0.0;
+		return false;
+    }
+
+    if (formula->cache == NULL && formula->circuit == NULL)
+		return startResidual<Policy>(variables, formula, low, high, result);
+
+    // the same residual formula may already have been solved down another path
+    unsigned long long key = formula->residualHash[0];
+    unsigned long long check = formula->residualHash[1];
+
+    if (formula->circuit != NULL && circuitLookup(formula->circuit, key, check, &formula->circuit->result)) {
+		*result = 0.0;
+		return false;
+    }
+
+    // a budgeted search doesn't look up anything before its first chance split, where a hit would hide the choices under it
+    AnytimeSearch* search = formula->anytime;
+    bool lookup = (formula->cache != NULL && (search == NULL || search->leadingFrames < search->frames.size()));
+
+    if (lookup && cacheLookup(formula->cache, key, check, *low, *high, result)) {
+		if (search != NULL)
+			anytimeLeaf(variables, formula, *result);
+		return false;
+    }
+
+    SearchFrame* frame = pushSearch(formula, afterResidual);
+    frame->low = *low;
+    frame->high = *high;
+    frame->nodesBefore = formula->stats.nodes;
+    frame->key = key;
+    frame->check = check;
+
+    return startResidual<Policy>(variables, formula, low, high, result);
+}
+
+// Starts on a residual formula that is neither satisfied nor failed yet, and has no unit clauses left if Policy propagates
+// them (see solve()): by a pure variable, by its components, or otherwise by splitting on the next variable (chosen by
+// Policy::Branching), whose false branch is solved first
+// @param variables -- a pointer to a vector of variables' probabilities
+// @param formula -- a pointer to the formula state
+// @param low, high -- the thresholds the caller cares about (see solve()), set to those of whatever comes next
+// @param result -- unused, since a residual formula always goes at least one node deeper
+// @return whether a node deeper has to be solved first, with low and high as its thresholds
+template <class Policy>
+bool startResidual(std::vector<double>* variables, Formula* formula, double* low, double* high, double* result)
+{
+	const ClauseDatabase& database = *formula->database;
+	std::vector<int>& clauseSats = formula->clauseSats;
+
+	// everything past this point on the trail belongs to this node
+	unsigned int trailMark = formula->trail.size();
+
+	// whether this node's heuristic and propagation times are measured (see SolveStats)
+	bool timed = (formula->stats.nodes & (TIMING_SAMPLE - 1)) == 0;
+	double phaseStart = 0.0;
+
+    // User wants to eliminate pure variables (those variables that only appear in a single state (positive or negative) in all the clauses in which they appaer)
+    if (Policy::pures) {
+
+		// A choice variable is pure when it has at least one active appearance (in an unsatisfied clause) and all of
+		// them are of one sign. Setting it to that sign satisfies those clauses and leaves every other clause as it is,
+		// so for any assignment of the other variables it does at least as well as the other sign, and a choice
+		// variable takes the better branch wherever it sits in the prefix. A variable with no active appearances
+		// doesn't matter either way and is left alone. Chance variables are weighted rather than chosen, so they
+		// are never pure. The candidates come from the counts kept by satisfyClauses(), so no clause is rescanned
+		int pureLiteral = nextPure(variables, formula);
+
+		// Found pure variable
+		if (pureLiteral != -1) {	// now assign pure var correctly, check for satisfaction, etc.
+			int pureVar = literalVar(pureLiteral);
+			int pureSign = literalNegative(pureLiteral) ? -1 : 1;
+
+		    formula->stats.pureEliminations++;
+		    if (timed)
+				phaseStart = phaseClock();
+		    assignVariable(pureVar, pureSign, formula);
+
+		    satisfyClauses(pureVar, formula);
+		    if (timed)
+				formula->stats.propagationTime += phaseClock() - phaseStart;
+
+		    // the pure variable's node has the same thresholds and probability as this one, and whatever is waiting
+		    // on this one undoes the assignment along with its own changes, so nothing needs to wait on it
+		    return true;
+		}
+    }
+
+    // Before splitting on a variable, see if the residual formula falls apart into independent pieces
+    if (formula->components) {
+		unsigned int startsAt = formula->componentStarts.size();
+		unsigned int clausesAt = formula->componentClauses.size();
+
+		if (findComponents(formula, &formula->componentClauses, &formula->componentStarts) > 1)
+			return startComponents(formula, low, high, startsAt, clausesAt);
+
+		formula->componentStarts.resize(startsAt);
+		formula->componentClauses.resize(clausesAt);
+    }
+
+    if (timed)
+		phaseStart = phaseClock();
+
+    // There is guaranteed to be an unassigned variable, because if there was not we would have retunred from allSat == TRUE.
+    // The current block is the first one that still has unassigned variables, and its lowest one is split on by default
+    // NOTE with no heuristic h1-3, this first unassigned variable will remain selected
+    // When solving one component the clauses of the others are marked satisfied, so their variables must be left
+    // alone. Variables without an active appearance don't change the probability either way, so skip them all
+    int nextVarIndex = -1;
+    int block = 0;
+    for (;; block++) {
+		for (int k = database.blockStart[block]; k < database.blockStart[block] + formula->blockFree[block]; k++) {
+			int v = formula->blockVars[k];
+
+			if ((nextVarIndex == -1 || v < nextVarIndex) && (!formula->components || activeAppearances(v, *formula) > 0))
+				nextVarIndex = v;
+		}
+
+		if (nextVarIndex != -1)
+			break;
+    }
+
+    // User wants to apply a splitting heuristic
+    nextVarIndex = Policy::Branching::pick(variables, formula, block, nextVarIndex);
+
+    if (timed)
+		formula->stats.heuristicTime += phaseClock() - phaseStart;
+
+    bool choice = (variables->at(nextVarIndex) == -1);
+    if (choice)
+		formula->stats.choiceSplits++;
+    else
+		formula->stats.chanceSplits++;
+
+    double trueProb = choice ? 1.0 : variables->at(nextVarIndex);
+    double falseProb = 1.0 - trueProb;
+
+    // What the false branch needs for this node to clear its thresholds. At a choice node those are the thresholds
+    // themselves. At a chance node, the node can't beat low if the false branch is too low to even with a certain true
+    // branch, and clears high if the false branch does so on its own (and a false branch of chance 0 doesn't matter at all)
+    double falseLow = *low;
+    double falseHigh = *high;
+    if (!choice) {
+		falseLow = falseProb > 0.0 ? (*low - trueProb) / falseProb : INFINITY;
+		falseHigh = falseProb > 0.0 ? *high / falseProb : INFINITY;
+    }
+
+    // If there is a pool and we are still near the top of the tree, hand the true branch to it as a task
+    // with its own copy of the formula, while this thread carries on down the false branch
+    // NOTE the task can't wait for the false branch, so its thresholds assume that one could come out anywhere from 0 to 1
+    SolverPool* pool = formula->pool;
+    SolveTask* trueTask = NULL;
+
+    if (pool != NULL && formula->decisionDepth < pool->spawnDepth
+    	&& (int)(clauseSats.size() - formula->numSatisfied) >= MIN_SPAWN_CLAUSES) {
+		trueTask = new SolveTask();
+		trueTask->solve = solve<Policy>;
+		trueTask->variables = variables;
+		trueTask->varIndex = nextVarIndex;
+		trueTask->low = *low;
+		trueTask->high = *high;
+		if (!choice) {
+			trueTask->low = trueProb > 0.0 ? (*low - falseProb) / trueProb : INFINITY;
+			trueTask->high = trueProb > 0.0 ? *high / trueProb : INFINITY;
+		}
+		trueTask->formula = *formula;
+		trueTask->formula.trail.clear();
+		trueTask->formula.searchDepth = 0;
+		trueTask->formula.componentClauses.clear();
+		trueTask->formula.componentStarts.clear();
+		trueTask->formula.stats = SolveStats();
+		trueTask->formula.decisionDepth++;
+		trueTask->done = false;
+
+		if (formula->cache != NULL) {
+			initCache(&trueTask->cache, std::max(1U, pool->cacheMB / pool->numThreads));
+			trueTask->formula.cache = &trueTask->cache;
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(pool->locks[formula->worker]);
+			pool->queues[formula->worker].push_back(trueTask);
+		}
+		pool->spawned++;
+    }
+
+    formula->decisionDepth++;
+    if (formula->anytime != NULL)
+		pushBoundFrame(formula, choice ? choiceFrame : chanceFrame, trueProb);
+
+    // trying false
+    if (timed)
+		phaseStart = phaseClock();
+    assignVariable(nextVarIndex, -1, formula);
+
+    // satify and test probabilities given false option
+    // NOTE rather than copying the formula for each branch, every change is recorded on the trail and
+    // rolled back once the branch has been explored (see resumeSearch())
+    satisfyClauses(nextVarIndex, formula);
+    if (timed)
+		formula->stats.propagationTime += phaseClock() - phaseStart;
+
+    SearchFrame* frame = pushSearch(formula, afterFalse);
+    frame->low = *low;
+    frame->high = *high;
+    frame->trailMark = trailMark;
+    frame->timed = timed;
+    frame->varIndex = nextVarIndex;
+    frame->choice = choice;
+    frame->trueProb = trueProb;
+    frame->falseLow = falseLow;
+    frame->falseHigh = falseHigh;
+    frame->trueTask = trueTask;
+
+    *low = falseLow;
+    *high = falseHigh;
+    return true;
+}
+
+// Carries on with the step on top of formula->searchStack, now that the node it was waiting on has been solved
+// @param formula -- a pointer to the formula state
+// @param low, high -- set to the thresholds of the next node, if there is one
+// @param result -- the probability of the node that was solved, set to that of the step once it is done
+// @return whether a node deeper has to be solved first, with low and high as its thresholds
+bool resumeSearch(Formula* formula, double* low, double* high, double* result)
+{
+	SearchFrame* frame = &formula->searchStack[formula->searchDepth - 1];
+
+	switch (frame->step) {
+	case afterFalse:
+		if (resumeSplit(formula, frame, low, high, result))
+			return true;
+		break;
+
+	case afterTrue:
+		undoTrail(formula, frame->trailMark);
+		*result = finishSplit(formula, frame, *result);
+		break;
+
+	case afterPropagated:
+		if (formula->anytime != NULL)
+			popBoundFrame(formula);
+		if (formula->circuit != NULL)
+			formula->circuit->result = scaledCircuitNode(formula, formula->circuit->result, frame->trailMark);
+		undoTrail(formula, frame->trailMark);
+
+		*result *= frame->weight;
+		break;
+
+	case afterResidual:
+		// a search cut short by its budget didn't finish the residual formula
+		if (formula->circuit != NULL)
+			circuitStore(formula->circuit, frame->key, frame->check, formula->circuit->result);
+		else if (formula->anytime == NULL || !formula->anytime->stopped) {
+			BoundType bound = exactValue;
+			if (*result <= frame->low)
+				bound = upperBound;
+			else if (*result >= frame->high)
+				bound = lowerBound;
+			cacheStore(formula->cache, frame->key, frame->check, *result, bound, formula->stats.nodes - frame->nodesBefore);
+		}
+		break;
+
+	case afterComponent:
+		if (resumeComponents(formula, frame, low, high, result))
+			return true;
+		break;
+	}
+
+	formula->searchDepth--;
+	return false;
+}
+
+// Carries on with a split once its false branch has been solved: works out the true branch, and starts it unless it
+// was handed to the pool or can't change the answer, in which case the split is finished here
+// @param formula -- a pointer to the formula state
+// @param frame -- the split (ptr), which moves on to afterTrue if the true branch is started
+// @param low, high -- set to the thresholds of the true branch, if it is started
+// @param result -- the probability of the false branch, set to that of the split if it is finished here
+// @return whether the true branch was started
+bool resumeSplit(Formula* formula, SearchFrame* frame, double* low, double* high, double* result)
+{
+	double probSatFalse = *result;
+	undoTrail(formula, frame->trailMark);
+
+    // NOTE the true branch starts lower on the trail than the bound frame did if nextPure() moved the pure queue head on
+    if (formula->anytime != NULL) {
+		BoundFrame& boundFrame = formula->anytime->frames.back();
+		boundFrame.second = true;
+		boundFrame.first = probSatFalse;
+		boundFrame.trailMark = formula->trail.size();
+    }
+
+    // What the true branch needs, now that the false branch is known. At a chance node that is whatever is left of the
+    // thresholds after the false branch's share, unless the false branch already settled which side of them the node is
+    // on, in which case the true branch is taken as 1 (too low) or 0 (high enough) without solving it. At a choice node the
+    // true branch isn't needed once the false one clears high (or, with pruning, reaches 1), and with pruning it has to beat the false one
+    double trueProb = frame->trueProb;
+    double falseProb = 1.0 - trueProb;
+    double trueLow = frame->low;
+    double trueHigh = frame->high;
+    bool skipTrue = false;
+    double skippedProb = 0.0;
+
+    if (!frame->choice) {
+		if (falseProb > 0.0 && probSatFalse <= frame->falseLow) {
+			skipTrue = true;
+			skippedProb = 1.0;
+		}
+		else if (falseProb > 0.0 && probSatFalse >= frame->falseHigh)
+			skipTrue = true;
+
+		trueLow = trueProb > 0.0 ? (frame->low - falseProb * probSatFalse) / trueProb : INFINITY;
+		trueHigh = trueProb > 0.0 ? (frame->high - falseProb * probSatFalse) / trueProb : INFINITY;
+    }
+    else {
+		skipTrue = (probSatFalse >= frame->high || (formula->prune && probSatFalse >= 1.0));
+		if (formula->prune)
+			trueLow = std::max(frame->low, probSatFalse);
+    }
+
+    frame->probSatFalse = probSatFalse;
+    if (formula->circuit != NULL)
+		frame->falseNode = formula->circuit->result;
+    double probSatTrue;
+
+    if (frame->trueTask != NULL) {
+		// wait for the true branch, and fold its counts into ours
+		SolverPool* pool = formula->pool;
+		SolveTask* trueTask = frame->trueTask;
+		probSatTrue = joinTask(pool, trueTask, formula->worker);
+		addStats(&formula->stats, trueTask->formula.stats);
+
+		if (formula->cache != NULL) {
+			formula->cache->hits += trueTask->cache.hits;
+			formula->cache->misses += trueTask->cache.misses;
+			formula->cache->evictions += trueTask->cache.evictions;
+		}
+
+		delete trueTask;
+
+		// a task's result was found without knowing the false branch, so if that one turned out to settle the node on its own,
+		// the task can only be trusted as far as the false branch's skipped probability (see above)
+		if (skipTrue && !frame->choice)
+			probSatTrue = skippedProb;
+    }
+    else if (skipTrue) {
+		// the true branch can't change the answer, so it gets whichever probability keeps the result a bound
+		if (frame->choice)
+			formula->stats.choiceCutoffs++;
+		else
+			formula->stats.chanceCutoffs++;
+
+		probSatTrue = skippedProb;
+    }
+    else {
+		// trying true
+		double phaseStart = frame->timed ? phaseClock() : 0.0;
+		assignVariable(frame->varIndex, 1, formula);
+
+		// satisfy and test given true option
+		satisfyClauses(frame->varIndex, formula);
+		if (frame->timed)
+			formula->stats.propagationTime += phaseClock() - phaseStart;
+
+		frame->step = afterTrue;
+		*low = trueLow;
+		*high = trueHigh;
+		return true;
+    }
+
+    *result = finishSplit(formula, frame, probSatTrue);
+    return false;
+}
+
+// Finishes a split once both of its branches are known
+// @param formula -- a pointer to the formula state
+// @param frame -- the split (ptr), holding the probability of its false branch
+// @param probSatTrue -- the probability of its true branch
+// @return the probability of the split
+double finishSplit(Formula* formula, SearchFrame* frame, double probSatTrue)
+{
+    formula->decisionDepth--;
+    if (formula->anytime != NULL)
+		popBoundFrame(formula);
+    if (formula->circuit != NULL) {
+		CircuitBuilder* builder = formula->circuit;
+		builder->result = splitCircuitNode(builder, frame->choice, frame->varIndex, frame->falseNode, builder->result);
+    }
+
+    if (frame->choice) { 	// v is a choice variable
+		return std::max(frame->probSatFalse, probSatTrue);	// so pick the maximum choice to optimize success
+    }
+
+    // v is a chance variable, so adjust both probabilites to account for all possibilites
+    return probSatTrue * frame->trueProb + frame->probSatFalse * (1.0 - frame->trueProb);
+}
+
+// Splitting heuristic one, which tries to maximize the number of unit clauses obtained quickly by choising the variable of
+// the current block that appears in the smallest current clause
+// NOTE the block's unassigned variables are in no particular order, so ties go to the lowest variable
+// @param variables -- a pointer to a vector of variables' probabilities
+// @param formula -- the formula being solved (ptr)
+// @param block -- the current block
+// @param nextVarIndex -- the default variable, kept if no variable of the block is in an unsatisfied clause
+int SmallestClauseBranch::pick(std::vector<double>* variables, Formula* formula, int block, int nextVarIndex)
+{
+	const ClauseDatabase& database = *formula->database;
+	const int* blockBegin = &formula->blockVars[database.blockStart[block]];
+	const int* blockEnd = blockBegin + formula->blockFree[block];
+	int minClauseLength = INT_MAX;		// start as the maximum int, so any reasonable first clause length will become the minimum
+
+	for (const int* b = blockBegin; b != blockEnd; b++) {
+		int i = *b;
+
+		// check the length of the clauses in which it appears and see if it's a new minimum
+		for (int o = database.occurrenceStart[2*i]; o < database.occurrenceStart[2*i + 2]; o++) {
+			if (formula->clauseSats[database.occurrences[o]] == 1)
+				continue;
+
+			int currLength = formula->clauseLengths[database.occurrences[o]];
+
+			// if it appears in the current smallest clause of those in the block, it's our next variable
+			if (currLength < minClauseLength || (currLength == minClauseLength && i < nextVarIndex)) {
+				minClauseLength = currLength;
+				nextVarIndex = i;
+			}
+		}
+	}
+
+	return nextVarIndex;
+}
+
+// Splitting heuristic two, which tries to simply pick the variable that appears in the greatest number of clauses
+// (see appearanceScore()), or three, which tries to pick the variable in the current block that satisfies the greatest number
+// of clauses in one step if assigned correctly, accounting for the probability of satisfaction and the separate instances of
+// positive vs negative appearances (see weightedScore()). Both keep their scores in the block's heap, so the best is on top
+// NOTE regardless of pos/neg scores, we will try both options below to cover the trees
+// @param variables -- a pointer to a vector of variables' probabilities
+// @param formula -- the formula being solved (ptr), whose score heaps initScores() has set up
+// @param block -- the current block
+// @param nextVarIndex -- the default variable, kept if no variable of the block appears anywhere
+int BestScoreBranch::pick(std::vector<double>* variables, Formula* formula, int block, int nextVarIndex)
+{
+	if (formula->scores.heapSize[block] == 0)
+		return nextVarIndex;
+
+	refreshScores(formula);
+	int best = formula->scores.heap[formula->database->blockStart[block]];
+
+	return formula->scores.scores[best] > 0.0 ? best : nextVarIndex;
+}
+
+// Checks for clause satisfaction and shortens clauses by their newly false literals, keeping the satisfied and active appearance counts
+// NOTE only the clauses in which the variable appears are visited (through the occurrence lists), so the cost follows the
+// variable's occurrences (and the lengths of those clauses) rather than the size of the formula
+// NOTE every change is pushed onto formula->trail so undoTrail() can reverse it
+// @param varIndex -- the current variable on which the solve algorithm has split
+// @param formula -- the formula whose satisfaction values, clause lengths and counts are adjusted directly (ptr)
+void satisfyClauses(int varIndex, Formula* formula)
+{
+	const ClauseDatabase& database = *formula->database;
+	std::vector<int>& sats = formula->clauseSats;
+	int trueLiteral = makeLiteral(varIndex, formula->assignments[varIndex] == -1);
+	int falseLiteral = negateLiteral(trueLiteral);
+
+	// every clause in which it is appearing UNSATISFIED (these go first, so that by the time a clause is satisfied
+	// every one of its false literals has been taken off its length and added to the residual hashes)
+	for (int o = database.occurrenceStart[falseLiteral]; o < database.occurrenceStart[falseLiteral + 1]; o++) {
+		int c = database.occurrences[o];
+
+		if (sats[c] == 1)
+		    continue;
+
+		// if you are marking the last remaining literal in the clause as unsatisfied, the entire clause is unsatisfied
+		if (formula->clauseLengths[c] == 1) {
+			formula->trail.push_back({ TrailType::setClauseSat, c, sats[c] });
+		    sats[c] = -1;
+		}
+		else {
+			// otherwise the clause is just one literal shorter, and the false literal loses that occurrence
+			formula->trail.push_back({ TrailType::shortenClause, c, falseLiteral });
+			formula->clauseLengths[c]--;
+		    formula->activeOccurrences[falseLiteral]--;
+		    formula->residualHash[0] += residualKey(c, falseLiteral, 0);
+		    formula->residualHash[1] += residualKey(c, falseLiteral, 1);
+		}
+    }
+
+	// every clause the literal satisfies
+	for (int o = database.occurrenceStart[trueLiteral]; o < database.occurrenceStart[trueLiteral + 1]; o++) {
+		int c = database.occurrences[o];
+
+    	// if the clause is already satisfied, ignore it!
+		if (sats[c] == 1)
+		    continue;
+
+		satisfyClause(c, formula);
+	}
+}
+
+// Marks a clause satisfied (on the trail) and takes it out of the satisfied count, active occurrences and residual hashes
+// @param c -- the unsatisfied clause
+// @param formula -- the formula holding the clause (ptr)
+void satisfyClause(int c, Formula* formula)
+{
+	const ClauseDatabase& database = *formula->database;
+
+	formula->trail.push_back({ TrailType::setClauseSat, c, formula->clauseSats[c] });
+	formula->clauseSats[c] = 1;
+	formula->numSatisfied++;
+	formula->residualHash[0] += residualKey(c, -1, 0);
+	formula->residualHash[1] += residualKey(c, -1, 1);
+
+	// every literal still active in the clause loses an active occurrence, while its false
+	// literals no longer count towards the residual hashes
+	for (int i = database.clauseStart[c]; i < database.clauseStart[c + 1]; i++) {
+		int literal = database.literals[i];
+
+		if (literalValue(literal, formula->assignments) != -1) {
+			dropOccurrence(literal, formula);
+			updateScore(literalVar(literal), formula);
+		}
+		else {
+			formula->residualHash[0] -= residualKey(c, literal, 0);
+			formula->residualHash[1] -= residualKey(c, literal, 1);
+		}
+	}
+}
+
+// Finds the connected components of the residual formula, where two unsatisfied clauses are connected when they
+// share an unassigned variable. This is a search out from each unassigned variable with active appearances, so the
+// cost is the size of the residual formula
+// @param formula -- the formula to split (ptr), whose marks are used as scratch space
+// @param componentClauses -- the clauses of every component are added on the end, one component after another
+// @param componentStart -- where each component starts in componentClauses is added on the end, plus one last entry for the end
+int findComponents(Formula* formula, std::vector<int>* componentClauses, std::vector<int>* componentStart)
+{
+	const ClauseDatabase& database = *formula->database;
+	std::vector<int> stack;
+	int stamp = ++formula->componentStamp;
+	int first = componentStart->size();
+
+	for (unsigned int v = 0; v < formula->assignments.size(); v++) {
+		if (formula->assignments[v] != 0 || activeAppearances(v, *formula) == 0 || formula->varMarks[v] == stamp)
+			continue;
+
+		// a new component, holding every clause reachable from this variable
+		componentStart->push_back(componentClauses->size());
+		formula->varMarks[v] = stamp;
+		stack.push_back(v);
+
+		while (!stack.empty()) {
+			int u = stack.back();
+			stack.pop_back();
+
+			for (int o = database.occurrenceStart[2*u]; o < database.occurrenceStart[2*u + 2]; o++) {
+				int c = database.occurrences[o];
+
+				if (formula->clauseSats[c] != 0 || formula->clauseMarks[c] == stamp)
+					continue;
+
+				formula->clauseMarks[c] = stamp;
+				componentClauses->push_back(c);
+
+				for (int i = database.clauseStart[c]; i < database.clauseStart[c + 1]; i++) {
+					int w = literalVar(database.literals[i]);
+
+					if (formula->assignments[w] == 0 && formula->varMarks[w] != stamp) {
+						formula->varMarks[w] = stamp;
+						stack.push_back(w);
+					}
+				}
+			}
+		}
+	}
+
+	componentStart->push_back(componentClauses->size());
+
+	return componentStart->size() - first - 1;
+}
+
+// Starts solving every component of a residual formula as if it were the whole formula, by marking the clauses of all
+// the other components satisfied for the duration, for the product of their probabilities (see resumeComponents())
+// NOTE this is sound for any quantifier ordering: a choice variable's max and a chance variable's weighted sum both
+// distribute over a product with a non-negative factor that doesn't depend on that variable, so working through the
+// prefix one variable at a time, the probability of the whole formula is the product of the probabilities of its parts.
+// Since each component is solved as a node of its own, it also gets its own entry in the residual formula cache.
+// Each component has to beat the low threshold divided by the product so far (the ones still to come could all be 1),
+// and as soon as one doesn't, the product so far times its upper bound is already too low to matter. Only the last
+// component can clear the high threshold for the product, since until then the rest could still be 0
+// @param formula -- a pointer to the formula state
+// @param low, high -- the thresholds the caller cares about (see solve()), set to those of the first component
+// @param startsAt, clausesAt -- where findComponents() put the components in formula->componentStarts and componentClauses
+// @return true, for the first component
+bool startComponents(Formula* formula, double* low, double* high, unsigned int startsAt, unsigned int clausesAt)
+{
+	formula->stats.componentSplits++;
+
+	SearchFrame* frame = pushSearch(formula, afterComponent);
+	frame->low = *low;
+	frame->high = *high;
+	frame->trailMark = formula->trail.size();
+	frame->component = 0;
+	frame->numComponents = formula->componentStarts.size() - startsAt - 1;
+	frame->startsAt = startsAt;
+	frame->clausesAt = clausesAt;
+	frame->probability = 1.0;
+	frame->productNode = 1;
+
+	// a budgeted search keeps the product so far and the best choices of the finished components on its path
+	if (formula->anytime != NULL) {
+		frame->boundFrame = formula->anytime->frames.size();
+		pushBoundFrame(formula, componentFrame, 1.0);
+	}
+
+	startComponent(formula, frame, low, high);
+	return true;
+}
+
+// Hides every component but the next one of a component split, and works out its thresholds
+// @param formula -- a pointer to the formula state
+// @param frame -- the component split (ptr)
+// @param low, high -- set to the thresholds of the component
+void startComponent(Formula* formula, SearchFrame* frame, double* low, double* high)
+{
+	const int* componentStart = &formula->componentStarts[frame->startsAt];
+	const std::vector<int>& componentClauses = formula->componentClauses;
+	int k = frame->component;
+	int numComponents = frame->numComponents;
+
+	// hide every other component
+	for (int i = componentStart[0]; i < componentStart[k]; i++)
+		satisfyClause(componentClauses[i], formula);
+	for (int i = componentStart[k + 1]; i < componentStart[numComponents]; i++)
+		satisfyClause(componentClauses[i], formula);
+
+	frame->componentLow = frame->low / frame->probability;
+	*low = frame->componentLow;
+	*high = (k == numComponents - 1) ? frame->high / frame->probability : INFINITY;
+	if (formula->anytime != NULL)
+		formula->anytime->frames[frame->boundFrame].second = (k == numComponents - 1);
+}
+
+// Carries on with a component split once one of its components has been solved, starting the next one unless that was
+// the last or the product is already settled
+// @param formula -- a pointer to the formula state
+// @param frame -- the component split (ptr)
+// @param low, high -- set to the thresholds of the next component, if there is one
+// @param result -- the probability of the component, set to the product of them all once the split is done
+// @return whether another component was started
+bool resumeComponents(Formula* formula, SearchFrame* frame, double* low, double* high, double* result)
+{
+	double componentProb = *result;
+	undoTrail(formula, frame->trailMark);
+
+	frame->probability *= componentProb;
+	if (formula->circuit != NULL)
+		frame->productNode = productCircuitNode(formula->circuit, frame->productNode, formula->circuit->result);
+	if (formula->anytime != NULL) {
+		BoundFrame& boundFrame = formula->anytime->frames[frame->boundFrame];
+		boundFrame.probability = frame->probability;
+		boundFrame.doneChoices.insert(boundFrame.doneChoices.end(), boundFrame.partChoices.begin(), boundFrame.partChoices.end());
+		boundFrame.partChoices.clear();
+		boundFrame.partLower = -1.0;
+	}
+
+	// a circuit's product is only settled when it is 0 whatever the chance probabilities
+	bool settled = (formula->circuit != NULL) ? frame->productNode == 0 : !(frame->probability > 0.0);
+
+	frame->component++;
+	if (componentProb > frame->componentLow && frame->component < frame->numComponents && !settled) {
+		startComponent(formula, frame, low, high);
+		return true;
+	}
+
+	if (formula->anytime != NULL)
+		popBoundFrame(formula);
+
+	// give back the split's space for the components, which is the last on the path
+	formula->componentStarts.resize(frame->startsAt);
+	formula->componentClauses.resize(frame->clausesAt);
+
+	if (formula->circuit != NULL)
+		formula->circuit->result = frame->productNode;
+
+	*result = frame->probability;
+	return false;
+}
+
+// Assigns a value to a variable, remembering the old value on the trail, and visits the clauses
+// watching the literal that the assignment just made false
+// NOTE the variable goes down as forced by nothing, and propagateUnits() fills in the clause that forced it afterwards
+// @param varIndex -- the variable to assign
+// @param value -- -1 for false, 1 for true
+// @param formula -- the formula holding the assignments and trail (ptr)
+void assignVariable(int varIndex, int value, Formula* formula)
+{
+	formula->trail.push_back({ TrailType::setAssignment, varIndex, formula->assignments[varIndex] });
+	formula->assignments[varIndex] = value;
+	formula->reasons[varIndex] = -1;
+	formula->assignedAt[varIndex] = formula->numAssigned;
+	formula->numAssigned++;
+
+	// take it out of its block's unassigned variables, by swapping it with the last of them
+	int block = formula->database->blockOf[varIndex];
+	int last = formula->database->blockStart[block] + --formula->blockFree[block];
+	int other = formula->blockVars[last];
+	formula->blockVars[formula->blockPositions[varIndex]] = other;
+	formula->blockPositions[other] = formula->blockPositions[varIndex];
+	formula->blockVars[last] = varIndex;
+	formula->blockPositions[varIndex] = last;
+	removeScore(varIndex, formula);
+
+	propagateWatches(makeLiteral(varIndex, value == 1), formula);
+}
+
+// Undoes every change on the trail past the given mark, newest first
+// @param formula -- the formula to roll back (ptr)
+// @param mark -- the trail size to roll back to
+void undoTrail(Formula* formula, unsigned int mark)
+{
+	const ClauseDatabase& database = *formula->database;
+
+	while (formula->trail.size() > mark) {
+		TrailEntry& e = formula->trail.back();
+
+		if (e.type == TrailType::setAssignment) {
+			formula->assignments[e.index] = e.value;
+			formula->numAssigned--;
+			formula->blockFree[database.blockOf[e.index]]++;	// it is still just past the block's unassigned variables
+			insertScore(e.index, formula);
+		}
+		else if (e.type == TrailType::setClauseSat) {
+			// a clause going back from satisfied hands its active occurrences back (the same literals are
+			// false as when it was satisfied, since everything after that has already been undone)
+			if (formula->clauseSats[e.index] == 1) {
+				formula->numSatisfied--;
+				formula->residualHash[0] -= residualKey(e.index, -1, 0);
+				formula->residualHash[1] -= residualKey(e.index, -1, 1);
+
+				for (int i = database.clauseStart[e.index]; i < database.clauseStart[e.index + 1]; i++) {
+					int literal = database.literals[i];
+
+					if (literalValue(literal, formula->assignments) != -1) {
+						formula->activeOccurrences[literal]++;
+						updateScore(literalVar(literal), formula);
+					}
+					else {
+						formula->residualHash[0] += residualKey(e.index, literal, 0);
+						formula->residualHash[1] += residualKey(e.index, literal, 1);
+					}
+				}
+			}
+			formula->clauseSats[e.index] = e.value;
+		}
+		else if (e.type == TrailType::shortenClause) {
+			formula->clauseLengths[e.index]++;
+			formula->activeOccurrences[e.value]++;
+			formula->residualHash[0] -= residualKey(e.index, e.value, 0);
+			formula->residualHash[1] -= residualKey(e.index, e.value, 1);
+		}
+		else if (e.type == TrailType::pushUnit) {
+			formula->unitQueue.pop_back();
+			formula->unitReasons.pop_back();
+		}
+		else if (e.type == TrailType::setUnitHead)
+			formula->unitHead = e.value;
+		else if (e.type == TrailType::pushPure)
+			formula->pureQueue.pop_back();
+		else if (e.type == TrailType::setPureHead)
+			formula->pureHead = e.value;
+		else
+			formula->conflict = (e.value == 1);
+
+		formula->trail.pop_back();
+	}
+}
+
+// Watches the first two literals of every clause. Clauses with a single literal watch it alone and are
+// queued as units straight away, and an empty clause can never be satisfied so it is a conflict from the start
+// @param formula -- the formula whose database has been read in (ptr)
+void initWatches(Formula* formula)
+{
+	const ClauseDatabase& database = *formula->database;
+
+	formula->watched.assign(2 * database.numClauses(), 0);
+	formula->watchLists.assign(2 * formula->assignments.size(), std::vector<int>());
+	formula->unitQueue.clear();
+	formula->unitReasons.clear();
+	formula->unitHead = 0;
+	formula->conflict = false;
+	formula->conflictClause = -1;
+
+	for (int c = 0; c < database.numClauses(); c++) {
+		const int* clause = &database.literals[0] + database.clauseStart[c];
+
+		if (database.clauseLength(c) == 0) {
+			formula->conflict = true;
+			continue;
+		}
+
+		formula->watchLists[clause[0]].push_back(c);
+
+		if (database.clauseLength(c) == 1) {
+			formula->unitQueue.push_back(clause[0]);
+			formula->unitReasons.push_back(c);
+			continue;
+		}
+
+		formula->watched[2*c + 1] = 1;
+		formula->watchLists[clause[1]].push_back(c);
+	}
+}
+
+// Finds the literals of a clause, which is one of the database's or, past them, a learned one (see LearnedClauses)
+// @param formula -- the formula holding the clause (ptr)
+// @param c -- the clause
+// @param length -- set to its number of literals (ptr)
+inline const int* clauseLiterals(const Formula* formula, int c, int* length)
+{
+	const ClauseDatabase& database = *formula->database;
+
+	if (c < database.numClauses()) {
+		*length = database.clauseLength(c);
+		return &database.literals[0] + database.clauseStart[c];
+	}
+
+	const LearnedClauses& learned = formula->learned;
+	*length = learned.length[c - database.numClauses()];
+	return &learned.literals[0] + learned.start[c - database.numClauses()];
+}
+
+// Visits only the clauses watching a literal that has just become false. Each one either moves that watch to
+// another literal that isn't false, or is left with just its other watch: if that is unassigned the clause is now
+// unit and the literal is queued, and if it is false too the clause can't be satisfied any more
+// @param falseLiteral -- the literal that the latest assignment made false
+// @param formula -- the formula whose watches and unit queue are updated (ptr)
+void propagateWatches(int falseLiteral, Formula* formula)
+{
+	std::vector<int>& watchers = formula->watchLists[falseLiteral];
+	std::vector<int>& assignments = formula->assignments;
+
+	// clauses that keep watching this literal are compacted to the front of the list as we go
+	unsigned int kept = 0;
+
+	for (unsigned int i = 0; i < watchers.size(); i++) {
+		int c = watchers[i];
+
+		// once we have a conflict the branch is dead, so just keep the remaining watchers where they are
+		if (formula->conflict) {
+			watchers[kept++] = c;
+			continue;
+		}
+
+		int length;
+		const int* clause = clauseLiterals(formula, c, &length);
+
+		// work out which of the two watches has just gone false
+		int falseSide = (clause[formula->watched[2*c]] == falseLiteral) ? 0 : 1;
+		int otherLiteral = clause[formula->watched[2*c + 1 - falseSide]];
+
+		// look for any other literal that isn't false to take over the watch
+		bool moved = false;
+		for (int l = 0; l < length; l++) {
+			if (l == formula->watched[2*c] || l == formula->watched[2*c + 1])
+				continue;
+
+			if (literalValue(clause[l], assignments) != -1) {
+				formula->watched[2*c + falseSide] = l;
+				formula->watchLists[clause[l]].push_back(c);
+				moved = true;
+				break;
+			}
+		}
+
+		if (moved)
+			continue;
+
+		watchers[kept++] = c;
+
+		// no replacement, so everything but the other watch is false
+		int otherValue = literalValue(otherLiteral, assignments);
+
+		if (otherValue == 0) {						// the clause is now unit on the other watch
+			formula->trail.push_back({ TrailType::pushUnit, c, otherLiteral });
+			formula->unitQueue.push_back(otherLiteral);
+			formula->unitReasons.push_back(c);
+		}
+		else if (otherValue == -1) {				// every literal is false
+			formula->trail.push_back({ TrailType::setConflict, c, formula->conflict ? 1 : 0 });
+			formula->conflict = true;
+			formula->conflictClause = c;
+		}
+	}
+
+	watchers.resize(kept);
+}
+
+// Skips past queued unit literals that have since been assigned (their clauses are already satisfied, since
+// a unit literal going false is a conflict) or whose clause belongs to another component (see startComponents()),
+// and returns the first one that is still unassigned
+// NOTE learned clauses have no satisfaction value, and are never learned while solving components
+// @param formula -- the formula holding the unit queue (ptr)
+int nextUnit(Formula* formula)
+{
+	while (formula->unitHead < formula->unitQueue.size()) {
+		int literal = formula->unitQueue[formula->unitHead];
+		unsigned int reason = formula->unitReasons[formula->unitHead];
+
+		if (formula->assignments[literalVar(literal)] == 0 && (reason >= formula->clauseSats.size() || formula->clauseSats[reason] != 1))
+			return literal;
+
+		formula->trail.push_back({ TrailType::setUnitHead, 0, (int)formula->unitHead });
+		formula->unitHead++;
+	}
+
+	return -1;
+}
+
+// Traces the conflict of the current node back to the clauses that caused it, and learns a clause that rules the same
+// failure out wherever it comes up again, so other branches find it by propagation instead of by search. Starting from
+// the clause that failed, the variables assigned since the last one nothing forced (the last split or pure variable,
+// which starts the current level) are resolved away newest first, each with the clause that forced it, until only one
+// of them is left (the first unique implication point). The learned clause is the false literal of that one and the
+// false literals of everything it took from before the current level
+// NOTE this only resolves clauses, so the learned clause follows from the database and holds under any quantifier
+// prefix. The search itself carries on as before (SSAT has to solve both branches of a split, so nothing is jumped
+// over), the learned clause just makes later nodes fail sooner
+// @param formula -- the formula with a conflict at the current node (ptr)
+void learnClause(Formula* formula)
+{
+	LearnedClauses& learned = formula->learned;
+	const std::vector<TrailEntry>& trail = formula->trail;
+	int numClauses = formula->database->numClauses();
+
+	// an empty clause fails whatever is assigned
+	if (formula->conflictClause == -1)
+		return;
+
+	// where the current level starts, and if nothing has been split on yet, no assignment of the choices works at all
+	int levelStart = -1;
+	for (int i = (int)trail.size() - 1; i >= 0; i--) {
+		if (trail[i].type == TrailType::setAssignment && formula->reasons[trail[i].index] == -1) {
+			levelStart = formula->assignedAt[trail[i].index];
+			break;
+		}
+	}
+
+	if (levelStart == -1)
+		return;
+
+	std::vector<int>& clause = formula->learnedClause;
+	clause.assign(1, -1);		// the implication point goes first, once it is known
+
+	int c = formula->conflictClause;
+	int open = 0;				// variables of the current level seen but not yet resolved away
+	unsigned int position = trail.size();
+	int pointVar = -1;
+	bool traced = true;
+
+	for (;;) {
+		if (c >= numClauses)
+			learned.activity[c - numClauses] += learned.bump;
+
+		int length;
+		const int* literals = clauseLiterals(formula, c, &length);
+
+		for (int l = 0; l < length; l++) {
+			int v = literalVar(literals[l]);
+			if (formula->seen[v])
+				continue;
+
+			formula->seen[v] = 1;
+			formula->seenVars.push_back(v);
+			if (formula->assignedAt[v] >= levelStart)
+				open++;
+			else
+				clause.push_back(literals[l]);
+		}
+
+		// a conflict with nothing from the current level (all of it assigned before the search, say) has no implication
+		// point, so there is nothing to learn and the search just backs out of it
+		if (open == 0) {
+			traced = false;
+			break;
+		}
+
+		// the newest assignment seen so far, which every other open one was assigned before
+		do
+			position--;
+		while (trail[position].type != TrailType::setAssignment || !formula->seen[trail[position].index]);
+
+		pointVar = trail[position].index;
+		if (--open == 0)
+			break;
+
+		// and the same if it leads back to a variable nothing forced, which has no clause to resolve with
+		c = formula->reasons[pointVar];
+		if (c == -1) {
+			traced = false;
+			break;
+		}
+	}
+
+	for (unsigned int i = 0; i < formula->seenVars.size(); i++)
+		formula->seen[formula->seenVars[i]] = 0;
+	formula->seenVars.clear();
+
+	if (!traced)
+		return;
+
+	clause[0] = makeLiteral(pointVar, formula->assignments[pointVar] == 1);
+
+	// the second watch goes on the literal that was assigned last, so backing out unassigns the watches first
+	for (unsigned int i = 2; i < clause.size(); i++) {
+		if (formula->assignedAt[literalVar(clause[i])] > formula->assignedAt[literalVar(clause[1])])
+			std::swap(clause[1], clause[i]);
+	}
+
+	// later uses count for more than earlier ones
+	learned.bump /= LEARNED_DECAY;
+	if (learned.bump > 1e100) {
+		for (unsigned int k = 0; k < learned.activity.size(); k++)
+			learned.activity[k] *= 1e-100;
+		learned.bump *= 1e-100;
+	}
+
+	if (learned.live >= learned.limit)
+		reduceLearned(formula);
+
+	// every clause left is the reason of a queued unit
+	if (learned.live >= learned.limit)
+		return;
+
+	int slot = learned.start.size();
+	if (!learned.freeSlots.empty()) {
+		slot = learned.freeSlots.back();
+		learned.freeSlots.pop_back();
+	}
+	else {
+		learned.start.push_back(0);
+		learned.length.push_back(0);
+		learned.activity.push_back(0.0);
+		formula->watched.resize(2 * (numClauses + learned.start.size()));
+	}
+
+	learned.start[slot] = learned.literals.size();
+	learned.length[slot] = clause.size();
+	learned.activity[slot] = learned.bump;
+	learned.literals.insert(learned.literals.end(), clause.begin(), clause.end());
+	learned.live++;
+	learned.pending = numClauses + slot;
+	formula->stats.learnedClauses++;
+
+	// a single literal is watched alone, like the unit clauses of the database
+	c = numClauses + slot;
+	formula->watched[2*c] = 0;
+	formula->watched[2*c + 1] = clause.size() > 1 ? 1 : 0;
+	formula->watchLists[clause[0]].push_back(c);
+	if (clause.size() > 1)
+		formula->watchLists[clause[1]].push_back(c);
+}
+
+// Makes room in a full learned clause database by deleting the less active half of its clauses. A clause that is the
+// reason of a queued unit is kept, since its literal may be assigned and a conflict traced back through it. Deleted
+// clauses are taken off their watches straight away, and their literals are squeezed out of the arena once they take
+// up more than half of it
+// @param formula -- the formula holding the learned clauses (ptr)
+void reduceLearned(Formula* formula)
+{
+	LearnedClauses& learned = formula->learned;
+	int numClauses = formula->database->numClauses();
+
+	std::vector<char> locked(learned.start.size(), 0);
+	for (unsigned int i = 0; i < formula->unitReasons.size(); i++) {
+		if (formula->unitReasons[i] >= numClauses)
+			locked[formula->unitReasons[i] - numClauses] = 1;
+	}
+
+	// least active first, and the older of two clauses as active as each other
+	std::vector<std::pair<double, int>> candidates;
+	for (unsigned int k = 0; k < learned.start.size(); k++) {
+		if (learned.length[k] != -1 && !locked[k])
+			candidates.push_back(std::make_pair(learned.activity[k], (int)k));
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	int deletions = std::min((int)candidates.size(), (learned.live + 1) / 2);
+	for (int i = 0; i < deletions; i++) {
+		int k = candidates[i].second;
+		int c = numClauses + k;
+		const int* clause = &learned.literals[0] + learned.start[k];
+
+		for (int side = 0; side < (learned.length[k] > 1 ? 2 : 1); side++) {
+			std::vector<int>& watchers = formula->watchLists[clause[formula->watched[2*c + side]]];
+			watchers.erase(std::find(watchers.begin(), watchers.end(), c));
+		}
+
+		learned.garbage += learned.length[k];
+		learned.length[k] = -1;
+		learned.freeSlots.push_back(k);
+		learned.live--;
+	}
+	formula->stats.learnedDeletions += deletions;
+
+	if (learned.garbage > (int)learned.literals.size() / 2) {
+		std::vector<int> literals;
+		literals.reserve(learned.literals.size() - learned.garbage);
+
+		for (unsigned int k = 0; k < learned.start.size(); k++) {
+			if (learned.length[k] == -1)
+				continue;
+
+			int start = literals.size();
+			literals.insert(literals.end(), learned.literals.begin() + learned.start[k], learned.literals.begin() + learned.start[k] + learned.length[k]);
+			learned.start[k] = start;
+		}
+
+		learned.literals.swap(literals);
+		learned.garbage = 0;
+	}
+}
+
+// Checks the latest learned clause once the search has backed out of the conflict it was learned from. It was learned
+// with every literal false and is watched on the two assigned last, so backing out leaves it unit (on its implication
+// point, or on a split's variable) without an assignment for the watches to notice. A clause that is unit is queued
+// (on the trail) for the node's propagation, and one that isn't is left to its watches
+// @param formula -- the formula holding the learned clauses (ptr)
+void assertLearned(Formula* formula)
+{
+	int c = formula->learned.pending;
+	formula->learned.pending = -1;
+
+	int length;
+	const int* clause = clauseLiterals(formula, c, &length);
+	int unitLiteral = -1;
+
+	for (int l = 0; l < length; l++) {
+		int value = literalValue(clause[l], formula->assignments);
+
+		if (value == 1)
+			return;
+		if (value == 0) {
+			if (unitLiteral != -1)
+				return;
+			unitLiteral = clause[l];
+		}
+	}
+
+	if (unitLiteral != -1) {
+		formula->trail.push_back({ TrailType::pushUnit, c, unitLiteral });
+		formula->unitQueue.push_back(unitLiteral);
+		formula->unitReasons.push_back(c);
+	}
+}
+
+// Takes an active occurrence away from a literal whose clause has just been satisfied. When that was the literal's
+// last one while its negation still has some, the negation has just become pure and is queued (on the trail)
+// @param literal -- the literal losing an occurrence
+// @param formula -- the formula holding the counts and the pure queue (ptr)
+void dropOccurrence(int literal, Formula* formula)
+{
+	if (--formula->activeOccurrences[literal] == 0 && formula->activeOccurrences[negateLiteral(literal)] > 0
+		&& formula->assignments[literalVar(literal)] == 0) {
+		formula->trail.push_back({ TrailType::pushPure, 0, negateLiteral(literal) });
+		formula->pureQueue.push_back(negateLiteral(literal));
+	}
+}
+
+// Skips past queued pure literals that have since been assigned, lost their last active occurrence (which only
+// happens to the variables of other components while startComponent() hides them) or belong to chance variables,
+// none of which can become pure again further down this branch, and returns the first one that is still pure
+// @param variables -- a pointer to a vector of variables' probabilities
+// @param formula -- the formula holding the pure queue (ptr)
+int nextPure(std::vector<double>* variables, Formula* formula)
+{
+	while (formula->pureHead < formula->pureQueue.size()) {
+		int literal = formula->pureQueue[formula->pureHead];
+		int varIndex = literalVar(literal);
+
+		if (variables->at(varIndex) == -1 && formula->assignments[varIndex] == 0
+			&& formula->activeOccurrences[literal] > 0 && formula->activeOccurrences[negateLiteral(literal)] == 0)
+			return literal;
+
+		formula->trail.push_back({ TrailType::setPureHead, 0, (int)formula->pureHead });
+		formula->pureHead++;
+	}
+
+	return -1;
+}
+
+// Sets up the score heaps of a formula for the splitting heuristic of a solution type (two and three keep their scores in
+// heaps, the others don't use any), holding every currently unassigned variable. From then on assignVariable(),
+// satisfyClause() and undoTrail() keep them up to date
+// NOTE every formula solved with heuristic two or three needs this, and another heuristic only needs a VariableScore of its
+// own here to reuse the heaps
+// @param formula -- the formula to score (ptr)
+// @param variables -- a pointer to a vector of variables' probabilities, which has to outlive the formula
+// @param directions -- the solution type the formula is going to be solved with
+void initScores(Formula* formula, const std::vector<double>* variables, SolutionType directions)
+{
+	const ClauseDatabase& database = *formula->database;
+	ScoreHeap& scores = formula->scores;
+	int numVars = formula->assignments.size();
+
+	scores.score = NULL;
+	if (directions == SolutionType::hTwo)
+		scores.score = appearanceScore;
+	else if (directions == SolutionType::hThree)
+		scores.score = weightedScore;
+	if (scores.score == NULL)
+		return;
+
+	scores.variables = variables;
+	scores.scores.assign(numVars, 0.0);
+	scores.heap.assign(numVars, -1);
+	scores.positions.assign(numVars, -1);
+	scores.heapSize.assign(database.blockStart.size() - 1, 0);
+	scores.staleVars.clear();
+	scores.stale.assign(numVars, 0);
+
+	for (int v = 0; v < numVars; v++) {
+		if (formula->assignments[v] == 0)
+			insertScore(v, formula);
+	}
+}
+
+// Heuristic two: the number of unsatisfied clauses the variable appears in
+// @param positive, negative -- the active occurrences of the variable's literals
+// @param probability -- the variable's probability (unused)
+double appearanceScore(int positive, int negative, double probability)
+{
+	return positive + negative;
+}
+
+// Heuristic three: the most unsatisfied clauses one value of the variable satisfies, where a chance variable's
+// appearances are weighted by the probability of the value that satisfies them
+// @param positive, negative -- the active occurrences of the variable's literals
+// @param probability -- the variable's probability (-1 for a choice variable)
+double weightedScore(int positive, int negative, double probability)
+{
+	double posCount = positive;
+	double negCount = negative;
+
+	if (probability != -1) {
+		posCount *= probability;
+		negCount *= (1 - probability);
+	}
+
+	return std::max(posCount, negCount);
+}
+
+// Marks a variable whose active occurrences have just changed as stale, so refreshScores() rescores it before the next split
+// @param varIndex -- the variable
+// @param formula -- the formula holding the heaps (ptr)
+void updateScore(int varIndex, Formula* formula)
+{
+	ScoreHeap& scores = formula->scores;
+
+	if (scores.score == NULL || scores.stale[varIndex])
+		return;
+
+	scores.stale[varIndex] = 1;
+	scores.staleVars.push_back(varIndex);
+}
+
+// Rescores every stale variable that is still in a heap and moves the ones whose score changed to their new place
+// @param formula -- the formula holding the heaps (ptr)
+void refreshScores(Formula* formula)
+{
+	ScoreHeap& scores = formula->scores;
+
+	for (unsigned int i = 0; i < scores.staleVars.size(); i++) {
+		int varIndex = scores.staleVars[i];
+		scores.stale[varIndex] = 0;
+
+		if (scores.positions[varIndex] == -1)
+			continue;
+
+		double score = scores.score(formula->activeOccurrences[2*varIndex], formula->activeOccurrences[2*varIndex + 1],
+									scores.variables->at(varIndex));
+		if (score == scores.scores[varIndex])
+			continue;
+
+		int block = formula->database->blockOf[varIndex];
+		scores.scores[varIndex] = score;
+		siftScore(formula->database->blockStart[block], scores.heapSize[block], scores.positions[varIndex], &scores);
+	}
+
+	scores.staleVars.clear();
+}
+
+// Scores a variable that has just become unassigned and puts it at the end of its block's heap, from where it moves up
+// @param varIndex -- the variable
+// @param formula -- the formula holding the heaps (ptr)
+void insertScore(int varIndex, Formula* formula)
+{
+	ScoreHeap& scores = formula->scores;
+
+	if (scores.score == NULL)
+		return;
+
+	int block = formula->database->blockOf[varIndex];
+	int position = formula->database->blockStart[block] + scores.heapSize[block]++;
+
+	scores.heap[position] = varIndex;
+	scores.positions[varIndex] = position;
+	scores.scores[varIndex] = scores.score(formula->activeOccurrences[2*varIndex], formula->activeOccurrences[2*varIndex + 1],
+										   scores.variables->at(varIndex));
+	siftScore(formula->database->blockStart[block], scores.heapSize[block], position, &scores);
+}
+
+// Takes a variable that has just been assigned out of its block's heap, putting the last entry in its place
+// @param varIndex -- the variable
+// @param formula -- the formula holding the heaps (ptr)
+void removeScore(int varIndex, Formula* formula)
+{
+	ScoreHeap& scores = formula->scores;
+
+	if (scores.score == NULL)
+		return;
+
+	int block = formula->database->blockOf[varIndex];
+	int position = scores.positions[varIndex];
+	int last = formula->database->blockStart[block] + --scores.heapSize[block];
+	int other = scores.heap[last];
+
+	scores.positions[varIndex] = -1;
+	if (other != varIndex) {
+		scores.heap[position] = other;
+		scores.positions[other] = position;
+		siftScore(formula->database->blockStart[block], scores.heapSize[block], position, &scores);
+	}
+}
+
+// Moves the entry at a position of a block's heap up while it beats its parent, or else down while a child beats it,
+// where a higher score wins and equal scores go to the lower variable
+// @param first -- where the block's heap starts in ScoreHeap::heap (the block's first variable)
+// @param size -- the number of entries in the block's heap
+// @param position -- the entry's position in ScoreHeap::heap
+// @param scores -- the heaps (ptr)
+void siftScore(int first, int size, int position, ScoreHeap* scores)
+{
+	std::vector<int>& heap = scores->heap;
+	const std::vector<double>& score = scores->scores;
+	int varIndex = heap[position];
+	int i = position - first;
+
+	// up
+	while (i > 0) {
+		int parent = heap[first + (i - 1) / 2];
+		if (score[parent] > score[varIndex] || (score[parent] == score[varIndex] && parent < varIndex))
+			break;
+
+		heap[first + i] = parent;
+		scores->positions[parent] = first + i;
+		i = (i - 1) / 2;
+	}
+
+	// down
+	while (2*i + 1 < size) {
+		int child = 2*i + 1;
+		if (child + 1 < size) {
+			int left = heap[first + child];
+			int right = heap[first + child + 1];
+			if (score[right] > score[left] || (score[right] == score[left] && right < left))
+				child++;
+		}
+
+		int best = heap[first + child];
+		if (score[varIndex] > score[best] || (score[varIndex] == score[best] && varIndex < best))
+			break;
+
+		heap[first + i] = best;
+		scores->positions[best] = first + i;
+		i = child;
+	}
+
+	heap[first + i] = varIndex;
+	scores->positions[varIndex] = first + i;
+}
+
+// Runs a spawned true branch on the task's own formula
+// @param task -- the task to run (ptr)
+// @param worker -- the pool worker running it, which is where any tasks it spawns in turn will be queued
+void runTask(SolveTask* task, int worker)
+{
+	task->formula.worker = worker;
+
+	assignVariable(task->varIndex, 1, &task->formula);
+	satisfyClauses(task->varIndex, &task->formula);
+	task->result = task->solve(task->variables, &task->formula, task->low, task->high);
+
+	task->done = true;
+}
+
+// Finds the next task for a worker: the newest on its own queue, or failing that the oldest on anyone else's
+// @param pool -- the pool (ptr)
+// @param worker -- the worker looking for something to do
+SolveTask* findTask(SolverPool* pool, int worker)
+{
+	{
+		std::lock_guard<std::mutex> guard(pool->locks[worker]);
+		if (!pool->queues[worker].empty()) {
+			SolveTask* task = pool->queues[worker].back();
+			pool->queues[worker].pop_back();
+			return task;
+		}
+	}
+
+	for (int i = 1; i < pool->numThreads; i++) {
+		int victim = (worker + i) % pool->numThreads;
+
+		std::lock_guard<std::mutex> guard(pool->locks[victim]);
+		if (!pool->queues[victim].empty()) {
+			SolveTask* task = pool->queues[victim].front();
+			pool->queues[victim].pop_front();
+			pool->stolen++;
+			return task;
+		}
+	}
+
+	return NULL;
+}
+
+// Waits for a task this worker spawned. If it is still at the back of our queue nobody has stolen it, so it is just
+// run here; otherwise we keep busy on other tasks until the thief is done with it
+// @param pool -- the pool (ptr)
+// @param task -- the task spawned by this worker (ptr)
+// @param worker -- the worker that spawned it
+double joinTask(SolverPool* pool, SolveTask* task, int worker)
+{
+	bool ours = false;
+	{
+		std::lock_guard<std::mutex> guard(pool->locks[worker]);
+		if (!pool->queues[worker].empty() && pool->queues[worker].back() == task) {
+			pool->queues[worker].pop_back();
+			ours = true;
+		}
+	}
+
+	if (ours)
+		runTask(task, worker);
+
+	while (!task->done) {
+		SolveTask* other = findTask(pool, worker);
+
+		if (other != NULL)
+			runTask(other, worker);
+		else
+			std::this_thread::yield();
+	}
+
+	return task->result;
+}
+
+// Keeps a pool thread stealing and running tasks until the main thread says the solve is over
+// @param pool -- the pool (ptr)
+// @param worker -- this thread's worker number
+void runWorker(SolverPool* pool, int worker)
+{
+	while (!pool->stop) {
+		SolveTask* task = findTask(pool, worker);
+
+		if (task != NULL)
+			runTask(task, worker);
+		else
+			std::this_thread::yield();
+	}
+}
+
+// Adds the counts of one search (a joined pool task) to another
+// @param total -- the counts to add to (ptr)
+// @param part -- the counts to add
+void addStats(SolveStats* total, const SolveStats& part)
+{
+	total->nodes += part.nodes;
+	total->choiceSplits += part.choiceSplits;
+	total->chanceSplits += part.chanceSplits;
+	total->unitPropagations += part.unitPropagations;
+	total->pureEliminations += part.pureEliminations;
+	total->conflicts += part.conflicts;
+	total->maxDepth = std::max(total->maxDepth, part.maxDepth);
+	total->componentSplits += part.componentSplits;
+	total->boundCutoffs += part.boundCutoffs;
+	total->choiceCutoffs += part.choiceCutoffs;
+	total->chanceCutoffs += part.chanceCutoffs;
+	total->learnedClauses += part.learnedClauses;
+	total->learnedDeletions += part.learnedDeletions;
+	total->heuristicTime += part.heuristicTime;
+	total->propagationTime += part.propagationTime;
+}
+
+// Writes the search counts, and the cache counts if there is a cache, as a single line JSON object. The heuristic and
+// propagation times are scaled up from their samples (see SolveStats)
+// @param stats -- the search counts
+// @param cache -- the cache of the search, or NULL
+// @param seconds -- the wall time of the whole solve
+std::string statsJson(const SolveStats& stats, const ComponentCache* cache, double seconds)
+{
+	std::ostringstream json;
+	json << "{\"seconds\":" << seconds
+		 << ",\"nodes\":" << stats.nodes
+		 << ",\"choice_splits\":" << stats.choiceSplits
+		 << ",\"chance_splits\":" << stats.chanceSplits
+		 << ",\"unit_propagations\":" << stats.unitPropagations
+		 << ",\"pure_eliminations\":" << stats.pureEliminations
+		 << ",\"conflicts\":" << stats.conflicts
+		 << ",\"max_depth\":" << stats.maxDepth
+		 << ",\"component_splits\":" << stats.componentSplits
+		 << ",\"bound_cutoffs\":" << stats.boundCutoffs
+		 << ",\"choice_cutoffs\":" << stats.choiceCutoffs
+		 << ",\"chance_cutoffs\":" << stats.chanceCutoffs
+		 << ",\"learned_clauses\":" << stats.learnedClauses
+		 << ",\"learned_deletions\":" << stats.learnedDeletions
+		 << ",\"heuristic_seconds\":" << stats.heuristicTime * TIMING_SAMPLE
+		 << ",\"propagation_seconds\":" << stats.propagationTime * TIMING_SAMPLE;
+
+	if (cache != NULL) {
+		json << ",\"cache_hits\":" << cache->hits
+			 << ",\"cache_misses\":" << cache->misses
+			 << ",\"cache_evictions\":" << cache->evictions
+			 << ",\"cache_entries\":" << cache->used;
+	}
+
+	json << "}";
+	return json.str();
+}
+
+// Adds the PROGRESS_CHECK_NODES nodes a formula has just visited to its progress report, and when the next line is due
+// writes it to the error stream. Whichever thread gets there first writes the line, and the others carry on
+// @param formula -- the formula being solved, with a progress report (ptr)
+void reportProgress(Formula* formula)
+{
+	ProgressReport* progress = formula->progress;
+	long long nodes = (progress->nodes += PROGRESS_CHECK_NODES);
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (now < progress->next || !progress->lock.try_lock())
+		return;
+
+	if (now >= progress->next) {
+		double elapsed = std::chrono::duration<double>(now - progress->start).count();
+		std::cerr << "Progress: " << elapsed << " seconds, " << nodes << " nodes (" << nodes / elapsed << " per second), "
+				  << formula->decisionDepth << " decisions deep, deepest " << formula->stats.maxDepth << " assignments" << std::endl;
+
+		progress->next = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(progress->interval));
+	}
+
+	progress->lock.unlock();
+}
+
+// Checks whether a budgeted search may go on, stopping it for good once it has visited nodeLimit nodes or run for
+// timeLimit seconds. The clock is only read every ANYTIME_CHECK_NODES nodes
+// @param formula -- the formula being solved (ptr), whose anytime search is set
+bool keepSearching(Formula* formula)
+{
+	AnytimeSearch* search = formula->anytime;
+	if (search->stopped)
+		return false;
+
+	if (search->nodeLimit > 0 && formula->stats.nodes >= search->nodeLimit)
+		search->stopped = true;
+	else if (search->timeLimit > 0.0 && (formula->stats.nodes & (ANYTIME_CHECK_NODES - 1)) == 0
+			 && std::chrono::duration<double>(std::chrono::steady_clock::now() - search->start).count() >= search->timeLimit) {
+		search->stopped = true;
+		search->timedOut = true;
+	}
+
+	return !search->stopped;
+}
+
+// Folds the probability of a node whose answer is known (a conflict, a satisfied formula, a cache hit or a unit chance
+// variable with no chance left) up the path of a budgeted search, to get bounds on the probability of the whole formula.
+// Every frame combines it the way solve() would, with whatever is already known about the rest: a finished false
+// branch or component counts as its probability, and anything not yet solved as 0 for the lower bound and 1 for the
+// upper one. Since every probability comes from such a node, the bounds are as tight as they can be at every step
+// NOTE the lower bound only goes up when the change makes it through every frame, so a choice split on the way is
+// on its true branch only if that one is doing better than the false one, and the choices on the path are the ones
+// that reach it. A component frame keeps the choices for the best of the component it is on in the same way, so the
+// choices of the finished ones are not lost once the search moves on
+// @param variables -- a pointer to a vector of variables' probabilities
+// @param formula -- the formula being solved (ptr), whose anytime search is set
+// @param probability -- the probability of the node
+void anytimeLeaf(const std::vector<double>* variables, Formula* formula, double probability)
+{
+	AnytimeSearch* search = formula->anytime;
+	double lower = probability;
+	double upper = probability;
+
+	for (int i = search->frames.size() - 1; i >= 0; i--) {
+		BoundFrame& frame = search->frames[i];
+
+		if (frame.type == choiceFrame) {
+			if (frame.second) {
+				lower = std::max(frame.first, lower);
+				upper = std::max(frame.first, upper);
+			}
+			else
+				upper = 1.0;
+		}
+		else if (frame.type == chanceFrame) {
+			double trueProb = frame.probability;
+			double falseProb = 1.0 - trueProb;
+
+			if (frame.second) {
+				lower = lower * trueProb + frame.first * falseProb;
+				upper = upper * trueProb + frame.first * falseProb;
+			}
+			else {
+				lower = lower * falseProb;
+				upper = upper * falseProb + trueProb;
+			}
+		}
+		else if (frame.type == scaleFrame) {
+			lower *= frame.probability;
+			upper *= frame.probability;
+		}
+		else {
+			if ((unsigned int)i < search->leadingFrames && lower > frame.partLower) {
+				frame.partLower = lower;
+				frame.partChoices = leadingChoices(variables, formula, frame.trailMark, i + 1);
+			}
+
+			// the components still to come could be anything from 0 to 1
+			lower = frame.second ? frame.probability * lower : 0.0;
+			upper *= frame.probability;
+		}
+	}
+
+	if (lower <= search->lower && upper >= search->upper)
+		return;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	double elapsed = std::chrono::duration<double>(now - search->start).count();
+
+	if (lower > search->lower) {
+		search->lower = lower;
+		search->lowerTime = elapsed;
+		search->bestChoices = leadingChoices(variables, formula, 0, 0);
+	}
+	search->upper = std::min(search->upper, upper);
+
+	if (search->reportInterval > 0.0 && now >= search->nextReport) {
+		std::cerr << "Bounds: " << search->lower << " to " << search->upper << " after " << elapsed << " seconds, "
+				  << formula->stats.nodes << " nodes" << std::endl;
+		search->nextReport = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(search->reportInterval));
+	}
+}
+
+// Starts a step on the path of a budgeted search, before anything of it is on the trail
+// @param formula -- the formula being solved (ptr), whose anytime search is set
+// @param type -- the kind of step
+// @param probability -- the chance of the true branch, the weight, or 1 for components (see BoundFrame)
+void pushBoundFrame(Formula* formula, BoundFrameType type, double probability)
+{
+	AnytimeSearch* search = formula->anytime;
+	if (type != chanceFrame && search->leadingFrames == search->frames.size())
+		search->leadingFrames++;
+
+	search->frames.push_back(BoundFrame());
+	BoundFrame& frame = search->frames.back();
+	frame.type = type;
+	frame.probability = probability;
+	frame.second = false;
+	frame.first = 0.0;
+	frame.trailMark = formula->trail.size();
+	frame.partLower = -1.0;
+}
+
+// Ends the last step on the path of a budgeted search
+// @param formula -- the formula being solved (ptr), whose anytime search is set
+void popBoundFrame(Formula* formula)
+{
+	AnytimeSearch* search = formula->anytime;
+	search->frames.pop_back();
+	search->leadingFrames = std::min(search->leadingFrames, (unsigned int)search->frames.size());
+}
+
+// The choice variables assigned on the path of a budgeted search before its first chance split, as signed variable
+// numbers: the ones on the trail from a position on, and the best of the finished components of the frames from one on
+// @param variables -- a pointer to a vector of variables' probabilities
+// @param formula -- the formula being solved (ptr), whose anytime search is set
+// @param mark -- the first trail position to look at
+// @param firstFrame -- the first frame whose finished components count
+std::vector<int> leadingChoices(const std::vector<double>* variables, Formula* formula, unsigned int mark, unsigned int firstFrame)
+{
+	AnytimeSearch* search = formula->anytime;
+	std::vector<int> choices;
+
+	for (unsigned int f = firstFrame; f < search->leadingFrames; f++) {
+		const std::vector<int>& done = search->frames[f].doneChoices;
+		choices.insert(choices.end(), done.begin(), done.end());
+	}
+
+	unsigned int end = formula->trail.size();
+	if (search->leadingFrames < search->frames.size())
+		end = search->frames[search->leadingFrames].trailMark;
+
+	for (unsigned int t = mark; t < end; t++) {
+		const TrailEntry& e = formula->trail[t];
+
+		if (e.type == TrailType::setAssignment && variables->at(e.index) == -1)
+			choices.push_back((e.index + 1) * formula->assignments[e.index]);
+	}
+
+	return choices;
+}
+
+// Sets up an empty cache that starts small and doubles as it fills, up to the memory cap
+// @param cache -- the cache to set up (ptr)
+// @param megabytes -- the most memory the table may take
+void initCache(ComponentCache* cache, unsigned int megabytes)
+{
+	cache->maxEntries = (unsigned long long)megabytes * 1024 * 1024 / sizeof(CacheEntry);
+	if (cache->maxEntries < CACHE_PROBES)
+		cache->maxEntries = CACHE_PROBES;
+
+	unsigned long long size = 1024;
+	while (size > cache->maxEntries)
+		size /= 2;
+
+	cache->entries.assign(size, CacheEntry());
+	cache->used = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->evictions = 0;
+}
+
+// Looks for a residual formula in the slots it could have been stored in. An exact probability is always a hit,
+// but an upper bound only when it is no higher than the low threshold, and a lower bound only when it is no lower
+// than the high one (see solve())
+// @param cache -- the cache to look in (ptr)
+// @param key, check -- the two residual hashes of the formula
+// @param low, high -- the thresholds the caller cares about
+// @param probability -- filled in with the remembered probability on a hit (ptr)
+bool cacheLookup(ComponentCache* cache, unsigned long long key, unsigned long long check, double low, double high, double* probability)
+{
+	if (key == 0)									// 0 is kept for empty slots
+		key = 1;
+
+	unsigned long long mask = cache->entries.size() - 1;
+
+	for (int p = 0; p < CACHE_PROBES; p++) {
+		CacheEntry& entry = cache->entries[(key + p) & mask];
+
+		if (entry.key == key && entry.check == check
+			&& (entry.bound == exactValue
+				|| (entry.bound == upperBound && entry.probability <= low)
+				|| (entry.bound == lowerBound && entry.probability >= high))) {
+			cache->hits++;
+			*probability = entry.probability;
+			return true;
+		}
+	}
+
+	cache->misses++;
+	return false;
+}
+
+// Stores a residual formula's probability. While the table is under its cap it doubles once it is half full,
+// and after that an entry whose slots are all taken evicts the one that took the fewest nodes to solve
+// @param cache -- the cache to store in (ptr)
+// @param key, check -- the two residual hashes of the formula
+// @param probability -- its success probability
+// @param bound -- whether the probability is exact or only a bound
+// @param work -- how many nodes it took to solve
+void cacheStore(ComponentCache* cache, unsigned long long key, unsigned long long check, double probability, BoundType bound, long long work)
+{
+	if (key == 0)
+		key = 1;
+
+	// grow while there is room under the cap, putting every entry back in its new place
+	if (cache->used * 2 >= cache->entries.size() && cache->entries.size() * 2 <= cache->maxEntries) {
+		std::vector<CacheEntry> old;
+		old.swap(cache->entries);
+		cache->entries.assign(old.size() * 2, CacheEntry());
+		cache->used = 0;
+
+		for (unsigned int i = 0; i < old.size(); i++) {
+			if (old[i].key != 0)
+				cacheStore(cache, old[i].key, old[i].check, old[i].probability, old[i].bound, old[i].work);
+		}
+	}
+
+	unsigned long long mask = cache->entries.size() - 1;
+	CacheEntry* victim = NULL;
+
+	for (int p = 0; p < CACHE_PROBES; p++) {
+		CacheEntry& entry = cache->entries[(key + p) & mask];
+
+		if (entry.key == key && entry.check == check) {	// already there, so only an exact probability is kept over a new bound
+			if (bound == exactValue || entry.bound != exactValue) {
+				entry.probability = probability;
+				entry.bound = bound;
+			}
+			return;
+		}
+
+		if (entry.key == 0) {						// a free slot
+			cache->used++;
+			victim = &entry;
+			break;
+		}
+
+		if (victim == NULL || entry.work < victim->work)
+			victim = &entry;
+	}
+
+	if (victim->key != 0)
+		cache->evictions++;
+
+	victim->key = key;
+	victim->check = check;
+	victim->probability = probability;
+	victim->bound = bound;
+	victim->work = work;
+}
+
+// Sets up a circuit with only the constants in it, and an empty memo
+// @param builder -- the circuit to set up (ptr)
+// @param variables -- the probabilities of the instance, which are kept with the circuit
+void initCircuit(CircuitBuilder* builder, const std::vector<double>& variables)
+{
+	Circuit& circuit = builder->circuit;
+
+	circuit.variables = variables;
+	circuit.types.clear();
+	circuit.vars.clear();
+	circuit.childStart.assign(1, 0);
+	circuit.children.clear();
+	addCircuitNode(builder, zeroNode, -1, NULL, 0);
+	addCircuitNode(builder, oneNode, -1, NULL, 0);
+	circuit.root = 0;
+
+	builder->result = 0;
+	builder->literalNodes.assign(2 * variables.size(), -1);
+	builder->memo.assign(1024, CircuitMemo());
+	builder->memoUsed = 0;
+	builder->reused = 0;
+}
+
+// Adds a node to the end of a circuit, after every node it could have as a child
+// @param builder -- the circuit (ptr)
+// @param type -- the kind of node
+// @param var -- its literal or variable (see Circuit), or -1
+// @param children, numChildren -- its children
+// @return the new node
+int addCircuitNode(CircuitBuilder* builder, CircuitNodeType type, int var, const int* children, int numChildren)
+{
+	Circuit& circuit = builder->circuit;
+
+	circuit.types.push_back(type);
+	circuit.vars.push_back(var);
+	circuit.children.insert(circuit.children.end(), children, children + numChildren);
+	circuit.childStart.push_back(circuit.children.size());
+
+	return circuit.types.size() - 1;
+}
+
+// The node of a chance literal, of which there is only ever one
+// @param builder -- the circuit (ptr)
+// @param literal -- a literal of a chance variable
+int literalCircuitNode(CircuitBuilder* builder, int literal)
+{
+	if (builder->literalNodes[literal] == -1)
+		builder->literalNodes[literal] = addCircuitNode(builder, literalNode, literal, NULL, 0);
+
+	return builder->literalNodes[literal];
+}
+
+// The node of the product of two nodes, which is one of them if the other is a constant
+// @param builder -- the circuit (ptr)
+// @param first, second -- the nodes to multiply, in the order the search multiplied their probabilities
+int productCircuitNode(CircuitBuilder* builder, int first, int second)
+{
+	if (first == 0 || second == 0)
+		return 0;
+	if (first == 1)
+		return second;
+	if (second == 1)
+		return first;
+
+	int children[2] = { first, second };
+	return addCircuitNode(builder, productNode, -1, children, 2);
+}
+
+// The node of a split, which is its branch if both branches are the same node (the larger of a node and itself, or its
+// weighted sum with itself, is that node whatever the probabilities)
+// @param builder -- the circuit (ptr)
+// @param choice -- whether the variable is a choice variable
+// @param varIndex -- the variable split on
+// @param falseNode, trueNode -- the nodes of its branches
+int splitCircuitNode(CircuitBuilder* builder, bool choice, int varIndex, int falseNode, int trueNode)
+{
+	if (falseNode == trueNode)
+		return falseNode;
+
+	int children[2] = { falseNode, trueNode };
+	return addCircuitNode(builder, choice ? choiceNode : chanceNode, varIndex, children, 2);
+}
+
+// The node of a probability scaled by the chance of the values unit propagation gave to chance variables, which are
+// every chance variable assigned past a trail position (the pure variables assigned there too are choice variables)
+// NOTE the literals come first, so evaluating the product multiplies their chances together and then the probability,
+// the same as solve() does
+// @param formula -- the formula being recorded (ptr)
+// @param node -- the node of the probability
+// @param mark -- the trail position the unit propagation started at
+int scaledCircuitNode(Formula* formula, int node, unsigned int mark)
+{
+	CircuitBuilder* builder = formula->circuit;
+	if (node == 0)
+		return 0;
+
+	std::vector<int> children;
+	for (unsigned int i = mark; i < formula->trail.size(); i++) {
+		const TrailEntry& e = formula->trail[i];
+
+		if (e.type == TrailType::setAssignment && builder->circuit.variables[e.index] != -1)
+			children.push_back(literalCircuitNode(builder, makeLiteral(e.index, formula->assignments[e.index] == -1)));
+	}
+
+	if (children.empty())
+		return node;
+
+	children.push_back(node);
+	return addCircuitNode(builder, productNode, -1, children.data(), children.size());
+}
+
+// Looks up the node of a residual formula, which is good for any thresholds since a circuit search has none
+// @param builder -- the circuit (ptr)
+// @param key, check -- the two residual hashes of the formula
+// @param node -- filled in with its node on a hit (ptr)
+bool circuitLookup(CircuitBuilder* builder, unsigned long long key, unsigned long long check, int* node)
+{
+	if (key == 0)									// 0 is kept for empty slots
+		key = 1;
+
+	unsigned long long mask = builder->memo.size() - 1;
+
+	for (unsigned long long i = key & mask; builder->memo[i].key != 0; i = (i + 1) & mask) {
+		if (builder->memo[i].key == key && builder->memo[i].check == check) {
+			builder->reused++;
+			*node = builder->memo[i].node;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Remembers the node of a residual formula, doubling the memo once it is half full
+// @param builder -- the circuit (ptr)
+// @param key, check -- the two residual hashes of the formula
+// @param node -- its node
+void circuitStore(CircuitBuilder* builder, unsigned long long key, unsigned long long check, int node)
+{
+	if (key == 0)
+		key = 1;
+
+	if (builder->memoUsed * 2 >= builder->memo.size()) {
+		std::vector<CircuitMemo> old;
+		old.swap(builder->memo);
+		builder->memo.assign(old.size() * 2, CircuitMemo());
+		builder->memoUsed = 0;
+
+		for (unsigned int i = 0; i < old.size(); i++) {
+			if (old[i].key != 0)
+				circuitStore(builder, old[i].key, old[i].check, old[i].node);
+		}
+	}
+
+	unsigned long long mask = builder->memo.size() - 1;
+	unsigned long long i = key & mask;
+	while (builder->memo[i].key != 0 && (builder->memo[i].key != key || builder->memo[i].check != check))
+		i = (i + 1) & mask;
+
+	if (builder->memo[i].key == 0)
+		builder->memoUsed++;
+
+	builder->memo[i].key = key;
+	builder->memo[i].check = check;
+	builder->memo[i].node = node;
+}
+
+// Evaluates a circuit for many vectors of chance probabilities, CIRCUIT_LANES at a time. The values of the nodes and
+// the probabilities of the variables are laid out lane by lane (node n's value in lane l is at n * CIRCUIT_LANES + l),
+// so every node is one pass of straight line arithmetic over CIRCUIT_LANES neighbouring doubles, and the last group
+// is padded out with copies of its first vector
+// NOTE a choice variable's entry in a vector is ignored, and every vector takes time linear in the size of the circuit
+// @param circuit -- the circuit to evaluate
+// @param probabilities -- the vectors, one after another, each with an entry for every variable of the circuit
+// @param count -- how many vectors there are
+// @param results -- filled in with the probability of each vector (ptr)
+void evaluateCircuit(const Circuit& circuit, const std::vector<double>& probabilities, int count, std::vector<double>* results)
+{
+	int numVars = circuit.variables.size();
+	int numNodes = circuit.types.size();
+	std::vector<double> values((size_t)numNodes * CIRCUIT_LANES);
+	std::vector<double> chances((size_t)numVars * CIRCUIT_LANES);
 
+	results->resize(count);
 
-// Main -- reads in the cmd args, runs File I/O, runs the SSAT solver, and reports statistics
-int main(int argc, char* argv[])
+	for (int first = 0; first < count; first += CIRCUIT_LANES) {
+		for (int l = 0; l < CIRCUIT_LANES; l++) {
+			int vector = (first + l < count) ? first + l : first;
+			for (int v = 0; v < numVars; v++)
+				chances[(size_t)v * CIRCUIT_LANES + l] = probabilities[(size_t)vector * numVars + v];
+		}
+
+		for (int n = 0; n < numNodes; n++) {
+			double* value = &values[(size_t)n * CIRCUIT_LANES];
+			const int* children = &circuit.children[0] + circuit.childStart[n];
+
+			switch (circuit.types[n]) {
+			case zeroNode:
+			case oneNode:
+				for (int l = 0; l < CIRCUIT_LANES; l++)
+					value[l] = (circuit.types[n] == oneNode) ? 1.0 : 0.0;
+				break;
+
+			case literalNode: {
+				const double* chance = &chances[(size_t)literalVar(circuit.vars[n]) * CIRCUIT_LANES];
+				if (literalNegative(circuit.vars[n])) {
+					for (int l = 0; l < CIRCUIT_LANES; l++)
+						value[l] = 1 - chance[l];
+				}
+				else {
+					for (int l = 0; l < CIRCUIT_LANES; l++)
+						value[l] = chance[l];
+				}
+				break;
+			}
+
+			case productNode: {
+				const double* child = &values[(size_t)children[0] * CIRCUIT_LANES];
+				for (int l = 0; l < CIRCUIT_LANES; l++)
+					value[l] = child[l];
+
+				for (int c = 1; c < circuit.childStart[n + 1] - circuit.childStart[n]; c++) {
+					child = &values[(size_t)children[c] * CIRCUIT_LANES];
+					for (int l = 0; l < CIRCUIT_LANES; l++)
+						value[l] *= child[l];
+				}
+				break;
+			}
+
+			case choiceNode: {
+				const double* falseValue = &values[(size_t)children[0] * CIRCUIT_LANES];
+				const double* trueValue = &values[(size_t)children[1] * CIRCUIT_LANES];
+				for (int l = 0; l < CIRCUIT_LANES; l++)
+					value[l] = std::max(falseValue[l], trueValue[l]);
+				break;
+			}
+
+			case chanceNode: {
+				const double* falseValue = &values[(size_t)children[0] * CIRCUIT_LANES];
+				const double* trueValue = &values[(size_t)children[1] * CIRCUIT_LANES];
+				const double* chance = &chances[(size_t)circuit.vars[n] * CIRCUIT_LANES];
+				for (int l = 0; l < CIRCUIT_LANES; l++)
+					value[l] = trueValue[l] * chance[l] + falseValue[l] * (1.0 - chance[l]);
+				break;
+			}
+			}
+		}
+
+		for (int l = 0; l < CIRCUIT_LANES && first + l < count; l++)
+			(*results)[first + l] = values[(size_t)circuit.root * CIRCUIT_LANES + l];
+	}
+}
+
+// Writes a circuit: a CircuitHeader followed by the variable probabilities and the node arrays, exactly as they are in
+// memory (so, like a compiled instance, it only loads on the same kind of machine)
+// @param fileName -- the name of the file to write
+// @param circuit -- the circuit
+int writeCircuitFile(std::string fileName, const Circuit& circuit)
 {
+	std::vector<char> payload;
+	const std::vector<int>* arrays[] = { &circuit.types, &circuit.vars, &circuit.childStart, &circuit.children };
 
-	// Command line arguments
-    if (argc != 3) {
-		std::cout << "Invalid Arguments (" << argc << "). Need [directions] [filetype] -- Exiting." << std::endl;
+	payload.insert(payload.end(), (const char*)circuit.variables.data(), (const char*)(circuit.variables.data() + circuit.variables.size()));
+	for (int a = 0; a < 4; a++)
+		payload.insert(payload.end(), (const char*)arrays[a]->data(), (const char*)(arrays[a]->data() + arrays[a]->size()));
+
+	CircuitHeader header;
+	memcpy(header.magic, CIRCUIT_MAGIC, sizeof(CIRCUIT_MAGIC));
+	header.version = CIRCUIT_VERSION;
+	header.numVars = circuit.variables.size();
+	header.numNodes = circuit.types.size();
+	header.numChildren = circuit.children.size();
+	header.root = circuit.root;
+	header.reserved = 0;
+	header.checksum = compiledChecksum(payload.data(), payload.size());
+
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file) {
+		std::cout << "Failed to open " << fileName << " for writing. Exiting." << std::endl;
 		return 1;
-    }
+	}
 
-    // Argument 1 determines the heuristic and solution-type method to adjust DPLL options
-    SolutionType directions;
-    if (std::string(argv[1]).compare("n") == 0)
-		directions = SolutionType::naive;
-    else if (std::string(argv[1]).compare("u") == 0)
-		directions = SolutionType::unit;
-    else if (std::string(argv[1]).compare("p") == 0)
-		directions = SolutionType::pure;
-    else if (std::string(argv[1]).compare("b") == 0)
-		directions = SolutionType::both;
-	else if (std::string(argv[1]).compare("1") == 0)
-		directions = SolutionType::hOne;
-	else if (std::string(argv[1]).compare("2") == 0)
-		directions = SolutionType::hTwo;
-	else if (std::string(argv[1]).compare("3") == 0)
-		directions = SolutionType::hThree;
-    else {
-		std::cout << "---" << argv[1] << "---" << std::endl;
-		std::cout << "Incorrect solving directions. Exiting." << std::endl;
+	file.write((const char*)&header, sizeof(header));
+	file.write(payload.data(), payload.size());
+
+	if (!file) {
+		std::cout << "Failed to write " << fileName << ". Exiting." << std::endl;
 		return 1;
-    }
+	}
 
-    std::string fileName = std::string(argv[2]);
+	std::cout << "Wrote " << fileName << " (" << (sizeof(header) + payload.size()) / (1024.0 * 1024.0) << " MB)" << std::endl;
+	return 0;
+}
 
-    //Initialize data structures to hold variables and clauses
+// Reads a circuit file (see writeCircuitFile()) after checking its magic, version, size and checksum, and that every
+// node only points back at nodes before it
+// @param fileName -- the name of the file to read
+// @param circuit -- the circuit to fill (ptr)
+// @param log -- where errors are written (ptr)
+int readCircuitFile(std::string fileName, Circuit* circuit, std::ostream* log)
+{
+	std::ifstream file(fileName, std::ios::binary);
+	if (!file) {
+		*log << "Failed to open " << fileName << ". Exiting." << std::endl;
+		return 1;
+	}
 
-    // Vector of all variables in order with their probabilities
-    // NOTE the value is the probability (-1 if choice variable)
-    // The variable itself is represented by the index + 1
-    std::vector<double> variables;
+	std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
 
-    // Vector of variable assignments where:
-    // -1 is false
-    // 0 is unassigned
-    // 1 is true
-    std::vector<int> assignments;
+	CircuitHeader header;
+	if (data.size() < sizeof(header) || memcmp(data.data(), CIRCUIT_MAGIC, sizeof(CIRCUIT_MAGIC)) != 0) {
+		*log << fileName << " is not a circuit file. Exiting." << std::endl;
+		return 1;
+	}
+	memcpy(&header, data.data(), sizeof(header));
 
-    // Vector of all clauses (where each clause is a vector)
-    std::vector<std::vector<int>> clauses;
+	if (header.version != CIRCUIT_VERSION) {
+		*log << "Circuit file has version " << header.version << ", expected " << CIRCUIT_VERSION
+			 << " (compile it again). Exiting." << std::endl;
+		return 1;
+	}
 
-    // Vector that shows whether each clause is satisfied where:
-    // -1 is unsatisfied
-    // 0 un unassigned
-    // 1 is satisfied
-    std::vector<int> clauseSats;
+	unsigned long long numInts = 3ULL * header.numNodes + 1 + header.numChildren;
+	unsigned long long expected = sizeof(CircuitHeader) + (unsigned long long)header.numVars * sizeof(double) + numInts * sizeof(int);
 
-    // Vector of variables that each contain a vector of the clause #s they appear in where
-    // the clause index is negative if the literal appeared negative, and positive if the literal appeared positive
-    // NOTE off by 1 error, where given varsByClause[a][b], you must index into clauses[] vect with -1
-    std::vector<std::vector<int>> varsByClause;
+	if (data.size() != expected) {
+		*log << "Circuit file is " << data.size() << " bytes, expected " << expected << ". Exiting." << std::endl;
+		return 1;
+	}
 
-    // Read file in and assign values to variables and clauses
-    // If file could not be opened, return 1
-    if (readSSATFile(fileName, &variables, &clauses, &varsByClause) == 1) {
+	const char* payload = data.data() + sizeof(CircuitHeader);
+	if (compiledChecksum(payload, data.size() - sizeof(CircuitHeader)) != header.checksum) {
+		*log << "Circuit file failed its checksum. Exiting." << std::endl;
 		return 1;
-    }
+	}
 
-    // Fill assignments such that each variable has an unassigned value
-    for (unsigned int i = 0; i < variables.size(); i++) {
-		assignments.push_back(0);
-    }
-	
-    // Fill clauseSats such that each clause is unassigned a satisfaction value
-    for (unsigned int i = 0; i < clauses.size(); i++) {
-		clauseSats.push_back(0);
-    }
+	circuit->variables.resize(header.numVars);
+	memcpy(circuit->variables.data(), payload, header.numVars * sizeof(double));
+	payload += header.numVars * sizeof(double);
 
-    //Start solving the SSAT Problem and time it
-    std::cout << "Beginning to solve!" << std::endl;
-    clock_t start = clock();
-    double solutionProb = solve(directions, &variables, clauses, clauseSats, &assignments, varsByClause);
-    clock_t end = clock();
+	std::vector<int>* arrays[] = { &circuit->types, &circuit->vars, &circuit->childStart, &circuit->children };
+	unsigned long long lengths[] = { header.numNodes, header.numNodes, header.numNodes + 1ULL, header.numChildren };
 
-    double solveTime  = (double)(end-start) / CLOCKS_PER_SEC;
-    std::cout << "Solution is: " << solutionProb << " (found in " << solveTime << " seconds)" << std::endl;
+	for (int a = 0; a < 4; a++) {
+		arrays[a]->resize(lengths[a]);
+		memcpy(arrays[a]->data(), payload, lengths[a] * sizeof(int));
+		payload += lengths[a] * sizeof(int);
+	}
+	circuit->root = header.root;
 
-    // all done!
-    return 0;
+	// evaluateCircuit() trusts every index, so a circuit that passed its checksum still has to make sense
+	bool valid = header.numNodes >= 2 && header.root < header.numNodes && circuit->childStart[0] == 0
+				 && circuit->childStart[header.numNodes] == (int)header.numChildren;
+
+	for (unsigned int n = 0; valid && n < header.numNodes; n++) {
+		int type = circuit->types[n];
+		int numChildren = circuit->childStart[n + 1] - circuit->childStart[n];
+
+		valid = (numChildren >= 0 && type >= zeroNode && type <= chanceNode);
+		if (valid && type == literalNode)
+			valid = (circuit->vars[n] >= 0 && circuit->vars[n] < 2 * (int)header.numVars);
+		if (valid && (type == choiceNode || type == chanceNode))
+			valid = (numChildren == 2 && circuit->vars[n] >= 0 && circuit->vars[n] < (int)header.numVars);
+		if (valid && type == productNode)
+			valid = (numChildren > 0);
+
+		for (int c = circuit->childStart[n]; valid && c < circuit->childStart[n + 1]; c++)
+			valid = (circuit->children[c] >= 0 && circuit->children[c] < (int)n);
+	}
+
+	if (!valid) {
+		*log << "Circuit file has a malformed node. Exiting." << std::endl;
+		return 1;
+	}
+
+	return 0;
 }
 
-//
-// Reads in a file with an ssat problem and fills the vector of variables, array of clauses, and
-// vector of variables that each contain a vector of the clause #s they appear in
-// @param fileName -- the name of the file to be opened and extracted
-// @param variables -- a pointer to a vector that can be filled with variable probabilites
-// @param clauses -- a pointer to a 2d vector that can be filled with the literals in each clause
-// @param varsByClause -- a pointer to a 2d vector that can store which clauses each variable appears in, and how
-int readSSATFile(std::string fileName,
-		 std::vector<double>* variables, 
-		 std::vector<std::vector<int>>* clauses,
-		 std::vector<std::vector<int>>* varsByClause)
+// "evaluate [circuit] [probabilities]" -- works out the probability of a compiled circuit (see --circuit) for every line
+// of the probabilities file, each of which holds the chance probabilities of the chance variables in order (lines
+// starting with # are skipped). Every other line is one vector, so the circuit of an instance without chance variables
+// is evaluated once per empty line, and for any other an empty line is an error. Without a probabilities file, the
+// circuit is evaluated for the probabilities of the instance it was compiled from. One probability is written per line,
+// and how long it took to the error stream
+// @param argc, argv -- the command line, where argv[1] is "evaluate"
+int runEvaluate(int argc, char* argv[])
 {
-    std::cout << "Reading in " << fileName << std::endl;
+	Circuit circuit;
+	if (readCircuitFile(argv[2], &circuit, &std::cout) == 1)
+		return 1;
 
-    //Does this construct an ifstream object?
-    std::ifstream file(fileName);
+	int numVars = circuit.variables.size();
+	std::vector<double> probabilities;
+	int count = 0;
 
-    //File could not be opened
-    if (!file) {
-		std::cout << "Failed to open file. Exiting." << std::endl;
-		return 1;
-    }
+	if (argc < 4) {
+		probabilities = circuit.variables;
+		count = 1;
+	}
+	else {
+		std::ifstream file(argv[3]);
+		if (!file) {
+			std::cout << "Failed to open " << argv[3] << ". Exiting." << std::endl;
+			return 1;
+		}
+
+		std::string line;
+		for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+			if (!line.empty() && line[0] == '#')
+				continue;
 
-    std::string line;
+			std::istringstream values(line);
+			double chance;
 
-    // begin running through entire file
-    while(getline(file, line)) {
+			for (int v = 0; v < numVars; v++) {
+				if (circuit.variables[v] == -1)
+					probabilities.push_back(-1);
+				else if (values >> chance && chance >= 0.0 && chance <= 1.0)
+					probabilities.push_back(chance);
+				else {
+					std::cout << "Line " << lineNumber << " of " << argv[3] << " needs a probability between 0 and 1 for every chance variable. Exiting." << std::endl;
+					return 1;
+				}
+			}
+
+			if (values >> chance) {
+				std::cout << "Line " << lineNumber << " of " << argv[3] << " has more probabilities than chance variables. Exiting." << std::endl;
+				return 1;
+			}
+			count++;
+		}
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<double> results;
+	evaluateCircuit(circuit, probabilities, count, &results);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::ostringstream output;
+	output.precision(17);
+	for (int i = 0; i < count; i++)
+		output << results[i] << "\n";
+	std::cout << output.str();
+
+	std::cerr << "Evaluated " << count << " probability vectors on " << circuit.types.size() << " nodes in " << seconds << " seconds" << std::endl;
+	return 0;
+}
 
-		if (line.compare("variables") == 0) {		// when you hit the variables line
-	    	getline(file, line);					// read in that "variables" token, move to the next line
+// Turns a solution type letter (n, u, p, b, 1, 2 or 3, see the readme) into its SolutionType
+// @param name -- the letter as given on the command line
+// @param directions -- filled in with the solution type (ptr)
+bool parseDirections(const std::string& name, SolutionType* directions)
+{
+	if (name.compare("n") == 0)
+		*directions = SolutionType::naive;
+	else if (name.compare("u") == 0)
+		*directions = SolutionType::unit;
+	else if (name.compare("p") == 0)
+		*directions = SolutionType::pure;
+	else if (name.compare("b") == 0)
+		*directions = SolutionType::both;
+	else if (name.compare("1") == 0)
+		*directions = SolutionType::hOne;
+	else if (name.compare("2") == 0)
+		*directions = SolutionType::hTwo;
+	else if (name.compare("3") == 0)
+		*directions = SolutionType::hThree;
+	else
+		return false;
+
+	return true;
+}
+
+// Picks the instantiation of solve() for a solution type, so the choice is made once rather than at every node
+// @param directions -- the solution type
+SolveFunction solverFor(SolutionType directions)
+{
+	if (directions == SolutionType::naive)
+		return solve<NaivePolicy>;
+	else if (directions == SolutionType::unit)
+		return solve<UnitPolicy>;
+	else if (directions == SolutionType::pure)
+		return solve<PurePolicy>;
+	else if (directions == SolutionType::both)
+		return solve<BothPolicy>;
+	else if (directions == SolutionType::hOne)
+		return solve<SmallestClausePolicy>;
+	else
+		return solve<BestScorePolicy>;
+}
+
+// Whether a solve can learn clauses from its conflicts (see learnClause()): only solution types that propagate unit
+// clauses know which clause forced each variable, and a learned clause can't be used while components are solved on
+// their own, since it may span them and force a variable of a component that is meant to be hidden
+// @param directions -- the solution type
+// @param components -- whether the solve splits the residual formula into components
+bool learnsClauses(SolutionType directions, bool components)
+{
+	return directions != SolutionType::naive && directions != SolutionType::pure && !components;
+}
 
-	    	while(line.compare("") != 0) {			// and begin filling variable vector
-				std::stringstream ss(line);
-				int varName = 0;
-				double varValue = 0.0;
+// Batch mode -- "batch [manifest or directory] [solution types] [options]", where the solution types are letters run
+// together (e.g. "b13") and every instance is solved with each of them. Rows go to the standard output as they finish,
+// in CSV (with a header) or JSONL, with the instance, solution type, probability, nodes visited and wall time of the solve
+// (and in JSONL, every counter of the solve, see statsJson())
+// Options:
+// --threads N -- solve N instances at a time (defaults to the number of CPUs)
+// --format csv|jsonl -- the row format (csv by default)
+// --cache-mb N, --components, --prune, --threshold T, --preprocess -- as for a single solve, for every solve of the batch
+// --learn N -- as for a single solve, for the solves it works with (see learnsClauses()), the others solve as they would without
+// NOTE each instance is read once by the worker that takes it and every solve of it runs on that worker's thread,
+// so the pool is bounded by --threads and there is no nested pool inside a solve
+// @param argc, argv -- the command line, where argv[1] is "batch"
+int runBatch(int argc, char* argv[])
+{
+	Batch batch;
+	batch.typeNames = argv[3];
+	batch.cacheMB = 0;
+	batch.components = false;
+	batch.prune = false;
+	batch.decide = false;
+	batch.threshold = 0.0;
+	batch.preprocess = false;
+	batch.learnLimit = 0;
+	batch.json = false;
+	batch.next = 0;
+	batch.failures = 0;
 
-				ss >> varName >> varValue;			// virst value is thrown out (or can be used to confirm)
+	for (unsigned int t = 0; t < batch.typeNames.size(); t++) {
+		SolutionType directions;
+		if (!parseDirections(batch.typeNames.substr(t, 1), &directions)) {
+			std::cout << "Incorrect solving directions " << batch.typeNames[t] << ". Exiting." << std::endl;
+			return 1;
+		}
+		batch.types.push_back(directions);
+	}
 
-				variables->push_back(varValue);		// pushed to the back of the variable vector
-				varsByClause->push_back(std::vector<int>());	// add an index for each variable (will just be the same size)
+	int threads = std::max(1U, std::thread::hardware_concurrency());
 
-				getline(file, line);			
-	    	}
+	for (int a = 4; a < argc; a++) {
+		if (std::string(argv[a]).compare("--threads") == 0 && a + 1 < argc)
+			threads = std::max(1, atoi(argv[++a]));
+		else if (std::string(argv[a]).compare("--format") == 0 && a + 1 < argc) {
+			std::string format = argv[++a];
+			if (format.compare("jsonl") == 0)
+				batch.json = true;
+			else if (format.compare("csv") != 0) {
+				std::cout << "Unknown format " << format << ". Exiting." << std::endl;
+				return 1;
+			}
+		}
+		else if (std::string(argv[a]).compare("--cache-mb") == 0 && a + 1 < argc)
+			batch.cacheMB = atoi(argv[++a]);
+		else if (std::string(argv[a]).compare("--components") == 0)
+			batch.components = true;
+		else if (std::string(argv[a]).compare("--prune") == 0)
+			batch.prune = true;
+		else if (std::string(argv[a]).compare("--threshold") == 0 && a + 1 < argc) {
+			batch.decide = true;
+			batch.threshold = atof(argv[++a]);
 		}
+		else if (std::string(argv[a]).compare("--preprocess") == 0)
+			batch.preprocess = true;
+		else if (std::string(argv[a]).compare("--learn") == 0 && a + 1 < argc)
+			batch.learnLimit = std::max(0, atoi(argv[++a]));
+		else {
+			std::cout << "Unknown option " << argv[a] << ". Exiting." << std::endl;
+			return 1;
+		}
+	}
 
-		if (line.compare("clauses") == 0) {			// now when you hit the clauses line
-		    getline(file, line);					// read in that token
+	if (listInstances(argv[2], &batch.files) == 1)
+		return 1;
 
-		    while(line.compare("") != 0) {			// fill clauses 
-				std::vector<int> clause;
-				std::stringstream ss(line);
-				int literal = variables->size() + 1;	// literal is set up (with an impossible value for verification)
-				ss >> literal;						// actual literal is filled
+	if (!batch.json) {
+		std::cout << "instance,type,probability," << (batch.decide ? "at_least," : "") << "nodes,seconds,error" << std::endl;
+	}
 
-				while (literal != 0) {
-				    clause.push_back(literal);		// fill this single clause
+	// this thread is one of the workers
+	threads = std::min(threads, std::max(1, (int)batch.files.size()));
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.push_back(std::thread(runBatchWorker, &batch));
 
-				    int litSign = 1;
+	runBatchWorker(&batch);
 
-				    if (literal < 0)				// confirm the correct sign
-						litSign = -1;
+	for (unsigned int t = 0; t < workers.size(); t++)
+		workers[t].join();
 
-				    varsByClause->at(abs(literal) - 1).push_back(((int)clauses->size() + 1) * litSign);
-				    ss >> literal;
-				}
+	return batch.failures > 0 ? 1 : 0;
+}
 
-				// add that entire clause and move to the next one
-				clauses->push_back(clause);
+// A manifest lists one instance per line (empty lines and lines starting with # are skipped, and relative paths are
+// taken from the manifest's directory). A directory gives every file in it ending in .ssat or .ssatb, sorted by name
+// @param source -- the manifest or directory
+// @param files -- filled in with the instance files (ptr)
+int listInstances(std::string source, std::vector<std::string>* files)
+{
+	struct stat info;
+	if (stat(source.c_str(), &info) != 0) {
+		std::cout << "Failed to open " << source << ". Exiting." << std::endl;
+		return 1;
+	}
 
-				getline(file,line);
-		    }
+	if (S_ISDIR(info.st_mode)) {
+		DIR* dir = opendir(source.c_str());
+		if (dir == NULL) {
+			std::cout << "Failed to open " << source << ". Exiting." << std::endl;
+			return 1;
 		}
-    }
 
-    return 0;
+		for (struct dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			bool text = name.size() > 5 && name.compare(name.size() - 5, 5, ".ssat") == 0;
+			bool compiled = name.size() > 6 && name.compare(name.size() - 6, 6, ".ssatb") == 0;
+
+			if (text || compiled)
+				files->push_back(source + "/" + name);
+		}
+
+		closedir(dir);
+		std::sort(files->begin(), files->end());
+		return 0;
+	}
+
+	std::ifstream manifest(source);
+	if (!manifest) {
+		std::cout << "Failed to open " << source << ". Exiting." << std::endl;
+		return 1;
+	}
+
+	std::string base = "";
+	if (source.find('/') != std::string::npos)
+		base = source.substr(0, source.rfind('/') + 1);
+
+	std::string line;
+	while (getline(manifest, line)) {
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		files->push_back(line[0] == '/' ? line : base + line);
+	}
+
+	return 0;
 }
 
-// Solves the SSAT problem using a DPLL-style SAT solver
-// Returns the maximum probability of success that can be found in the SSAT encoding (and therefore the probability of success of the underlying plans)
-// @param directions -- a SolutionType enum that dictates how certain heuristics will speed up the algorithm
-// @param variables -- a pointer to a vector of variables' probabilities
-// @param clauses -- a 2d vector that stores what active literals each clause contains NOTE this is a copy so recursive changes do not have to be undone
-// @param clauseSats -- a vector storing the satisfaction value of every clause (each index in clauses<>) NOTE copied (see clauses)
-// @param assignments -- a pointer to a vector of assignments for each variable (each index in variables<> and varsByClause<>)
-// @param varsByClause -- a 2d vector that stores the number of clauses in which a literal appears active NOTE copies (see clauses)
-double solve(SolutionType directions,
-	     std::vector<double>* variables,
-	     std::vector<std::vector<int>> clauses,
-	     std::vector<int> clauseSats,
-	     std::vector<int>* assignments,
-	     std::vector<std::vector<int>> varsByClause)
-{
-
-	// first, check if there are any unsatisfied or unassigned clauses
-    bool allSat = true;
-
-    for (unsigned int i = 0; i < clauseSats.size(); i++) {
-		if (clauseSats[i] == -1)	        				// if any clause is unsatisfied, this branch of the plan fails
-		    return 0.0;
-		else if (clauseSats[i] == 0)						// if any clause is unassigned, there is no satisfaction yet
-		    allSat = false;
-    }
-
-    if (allSat)	       										// if every clause is satisfied, return success for this plan
-		return 1.0;
-
-    //User wants solution to execute unit clause propogation
-    if (directions == SolutionType::unit || directions == SolutionType::both
-    	 || directions == SolutionType::hOne || directions == SolutionType::hTwo || directions == SolutionType::hThree) {
-		int unitVar	= 0;
-
-		// if there are any clauses that are size one and have not been satisfied yet
-		for (unsigned int c = 0; c < clauses.size(); c++) {
-		    if (clauses[c].size() == 1 && clauseSats[c] == 0) {
-				unitVar = clauses[c][0];
-				break;
-		    }
+// Solves instances of a batch until there are none left, writing a row for every solution type of each
+// NOTE an instance that can't be read still gets its rows, with the reason in the error field
+// @param batch -- the batch being run (ptr)
+void runBatchWorker(Batch* batch)
+{
+	for (unsigned int f = batch->next++; f < batch->files.size(); f = batch->next++) {
+		std::string fileName = batch->files[f];
+		std::vector<double> variables;
+		ClauseDatabase database;
+
+		// the reader's messages are only kept for the error of a file that can't be read
+		std::ostringstream log;
+		std::string error = "";
+
+		if (readSSATFile(fileName, &variables, &database, &log) == 1) {
+			error = lastError(log.str());
+			batch->failures++;
 		}
-	    
-		// then we have found a unit clause
-		if (unitVar != 0) {
+		else if (batch->preprocess)
+			preprocessSSAT(variables, &database, &log);
+
+		double low = -INFINITY;
+		double high = INFINITY;
+		if (batch->decide) {
+			low = batch->threshold - DECISION_TOLERANCE;
+			high = batch->threshold;
+		}
+
+		for (unsigned int t = 0; t < batch->types.size(); t++) {
+			double probability = 0.0;
+			long long nodes = 0;
+			double seconds = 0.0;
+			std::string stats = "";
+
+			if (error.empty()) {
+				Formula formula;
+				initFormula(&formula, &database, variables.size());
+				initScores(&formula, &variables, batch->types[t]);
+				formula.components = batch->components;
+				formula.prune = batch->prune;
+				if (learnsClauses(batch->types[t], batch->components))
+					formula.learned.limit = batch->learnLimit;
 
-			// set the assignment to fulfill that unit clause
-		    assignments->at(abs(unitVar)-1) = unitVar / abs(unitVar);
+				ComponentCache cache;
+				if (batch->cacheMB > 0) {
+					initCache(&cache, batch->cacheMB);
+					formula.cache = &cache;
+				}
+
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				probability = solverFor(batch->types[t])(&variables, &formula, low, high);
+				seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				nodes = formula.stats.nodes;
+				stats = statsJson(formula.stats, formula.cache, seconds);
+			}
 
-		    // satisfy and deactivate clauses and literals and recursively solve the remainder of the encoding
-		    satisfyClauses(abs(unitVar)-1, &clauses, &clauseSats, assignments, &varsByClause);
-		    double probSatUnit = solve(directions, variables, clauses, clauseSats, assignments, varsByClause);
+			std::ostringstream row;
+			row.precision(17);
+			std::string typeName = batch->typeNames.substr(t, 1);
 
-		    if (variables->at(abs(unitVar)-1) == -1)		// if choice, return the probability of success (other option is 0.0)
-				return probSatUnit;
-		    else {
-				if (assignments->at(abs(unitVar)-1) == 1)					// if it's a chance, return the appropriate chance of success given assignment
-				    return probSatUnit * variables->at(abs(unitVar)-1);
+			if (batch->json) {
+				row << "{\"instance\":" << jsonString(fileName) << ",\"type\":" << jsonString(typeName);
+				if (error.empty()) {
+					row << ",\"probability\":" << probability;
+					if (batch->decide)
+						row << ",\"at_least\":" << (probability > low ? "true" : "false");
+					row << ",\"nodes\":" << nodes << ",\"seconds\":" << seconds << ",\"stats\":" << stats << "}";
+				}
+				else
+					row << ",\"error\":" << jsonString(error) << "}";
+			}
+			else {
+				row << csvField(fileName) << "," << typeName << ",";
+				if (error.empty()) {
+					row << probability << ",";
+					if (batch->decide)
+						row << (probability > low ? "yes" : "no") << ",";
+					row << nodes << "," << seconds << ",";
+				}
 				else
-				    return probSatUnit * (1 - variables->at(abs(unitVar)-1));
-		    }
+					row << (batch->decide ? ",,,," : ",,,") << csvField(error);
+			}
+
+			std::lock_guard<std::mutex> guard(batch->outputLock);
+			std::cout << row.str() << std::endl;
 		}
-    }
+	}
+}
 
-    // User wants to eliminate pure variables (those variables that only appear in a single state (positive or negative) in all the clauses in which they appaer)
-    if (directions == SolutionType::pure || directions == SolutionType::both
-    	 || directions == SolutionType::hOne || directions == SolutionType::hTwo || directions == SolutionType::hThree) {
+// The last line a reader wrote to its log, which is the error when it failed, without the " Exiting." at its end
+// @param log -- everything the reader wrote
+std::string lastError(const std::string& log)
+{
+	std::string message = log;
+	message.erase(message.find_last_not_of("\n") + 1);
 
-		int pureVar = -1;
+	std::string error = message.substr(message.rfind('\n') + 1);
+	if (error.size() > 9 && error.compare(error.size() - 9, 9, " Exiting.") == 0)
+		error.erase(error.size() - 9);
 
-		// try to find any pure variables
-		for (int l = 0; l < (signed int)varsByClause.size(); l++) {
-		    if (variables->at(l) != -1 || assignments->at(l) != 0)	// only looking at unassigned choice variables 
-				continue;
+	return error;
+}
 
-		    for (unsigned int c = 1; c < varsByClause[l].size(); c++) {
-				pureVar = l;
+// Quotes a CSV field if it holds a comma, a quote or a line break, doubling any quotes
+// @param field -- the field to write
+std::string csvField(const std::string& field)
+{
+	if (field.find_first_of(",\"\r\n") == std::string::npos)
+		return field;
 
-				// Variable is not pure CONFUSED
-				if (varsByClause[l].size() < 1 || !((varsByClause[l][c-1] < 0 && varsByClause[l][c] < 0) || (varsByClause[l][c-1] > 0 && varsByClause[l][c] > 0))) {
-				    pureVar = -1;
-				    break;
-				}
-		    }
+	std::string quoted = "\"";
+	for (unsigned int i = 0; i < field.size(); i++) {
+		if (field[i] == '"')
+			quoted += '"';
+		quoted += field[i];
+	}
+	return quoted + "\"";
+}
 
-		    // If we've made it out of the above loop, variable is pure
-		    if (pureVar == l) 
-				break;
+// Quotes a JSON string, escaping quotes, backslashes and control characters
+// @param text -- the string to write
+std::string jsonString(const std::string& text)
+{
+	std::string quoted = "\"";
+	for (unsigned int i = 0; i < text.size(); i++) {
+		unsigned char c = text[i];
+		if (c == '"' || c == '\\') {
+			quoted += '\\';
+			quoted += c;
+		}
+		else if (c < 0x20) {
+			char escape[8];
+			snprintf(escape, sizeof(escape), "\\u%04x", c);
+			quoted += escape;
 		}
+		else
+			quoted += c;
+	}
+	return quoted + "\"";
+}
 
-		// Found pure variable
-		if (pureVar != -1) {	// now assign pure var correctly, check for satisfaction, etc.
-		    assignments->at(pureVar) = varsByClause[pureVar][0] / abs(varsByClause[pureVar][0]);
+// Benchmarks satisfyClauses() by assigning and undoing random variables on generated 3-literal formulas. Each
+// row quadruples the number of variables at a fixed number of occurrences per variable, and each column quadruples the
+// occurrences, so the time per assignment should stay flat down a column and grow along a row
+void benchSatisfyClauses()
+{
+	const int assignmentsPerRun = 200000;
+	srand(1);
+
+	std::cout << "vars\toccurrences\tns per assignment" << std::endl;
+
+	for (int numVars = 1000; numVars <= 64000; numVars *= 4) {
+		for (int occurrences = 3; occurrences <= 48; occurrences *= 4) {
+			ClauseDatabase database;
+			int numClauses = numVars * occurrences / 3;
+
+			database.clauseStart.assign(1, 0);
+			for (int c = 0; c < numClauses; c++) {
+				for (int l = 0; l < 3; l++)
+					database.literals.push_back(makeLiteral(rand() % numVars, rand() % 2 == 0));
+				database.clauseStart.push_back(database.literals.size());
+			}
+			buildOccurrences(&database, numVars);
+			buildBlocks(std::vector<double>(numVars, -1), &database);
 
-		    satisfyClauses(pureVar, &clauses, &clauseSats, assignments, &varsByClause);
-		    return solve(directions, variables, clauses, clauseSats, assignments, varsByClause);
+			Formula formula;
+			initFormula(&formula, &database, numVars);
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int a = 0; a < assignmentsPerRun; a++) {
+				int v = rand() % numVars;
+				assignVariable(v, (rand() % 2 == 0) ? 1 : -1, &formula);
+				satisfyClauses(v, &formula);
+				undoTrail(&formula, 0);
+			}
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+			double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / (double)assignmentsPerRun;
+			std::cout << numVars << "\t" << occurrences << "\t" << ns << std::endl;
 		}
-    }
+	}
+}
 
-    // There is guaranteed to be a 0 in assignments, because if there was not we would have retunred from allSat == TRUE
-    // NOTE with no heuristic h1-3, this first unassigned variable will remain selected
-    int nextVarIndex = std::distance(assignments->begin(), std::find(assignments->begin(), assignments->end(), 0));
-    
-    // User wants to apply splitting heuristic one, which tries to maximize the number of unit clauses obtained quickly
-    // by choising the variable of the current block that appears in the smallest current clause
-    if (directions == SolutionType::hOne) {
-    	int minClauseLength = INT_MAX;		// start as the maximum int, so any reasonable first clause length will become the minimum
-
-   		// decide the current block
-   		bool choiceVar = (variables->at(nextVarIndex) == -1);
-
-   		// now run through every variable in the current block
-   		bool currBlock = true;
-   		for (int i = nextVarIndex; currBlock; i++) {
-
-  			// make sure we're still in the block
-    		if (i+1 == varsByClause.size())
-    			currBlock = false;
-    		else if (choiceVar) {
-    			if (variables->at(i+1) != -1)	// chance when there should be choice
-    				currBlock = false;
-    		} else {
-    			if (variables->at(i+1) == -1)	// choice when there should be chance
-    				currBlock = false;
-    		}
-
-   			// if the variable is already assigned, move on (check the next variable first to see if we can continue the loop!)
-   			if (assignments->at(i) != 0)
-   				continue;
-
-   			// if we've found a variable of the currnet block, check the length of the clauses in which it appears and see if it's a new minimum
-   			for (unsigned int c = 0; c < varsByClause[i].size(); c++) {
-   				int currLength = clauses[abs(varsByClause[i][c]) - 1].size();
-
-   				if (currLength < minClauseLength) {
-   					minClauseLength = currLength;		// if it appears in the current smallest clause of those in the block, it's our next variable
-   					nextVarIndex = i;
-   				}
-   			}
-   		}
-    }
-
-    // User wants to apply splitting heuristic two, which tries to simply pick the variable that appears in the greatest number of clauses
-    // NOTE this heuristic does not account for probability of satisfaction or distribution of pos vs. neg appearances
-    if (directions == SolutionType::hTwo) {
-    	int maxCount = 0;
-
-    	bool choiceVar = (variables->at(nextVarIndex) == -1);
-
-    	bool currBlock = true;
-
-    	for (int i = nextVarIndex; currBlock; i++) {
-    		int currCount = 0;
-
-  			// make sure we're still in the block
-    		if (i+1 == varsByClause.size())
-    			currBlock = false;
-    		else if (choiceVar) {
-    			if (variables->at(i+1) != -1)	// chance when there should be choice
-    				currBlock = false;
-    		} else {
-    			if (variables->at(i+1) == -1)	// choice when there should be chance
-    				currBlock = false;
-    		}
-
-    		if (assignments->at(i) != 0)
-    			continue;
-
-    		// simply count the number of appearances 
-    		currCount = varsByClause[nextVarIndex].size();
-
-    		// and keep track of the maximum appearances
-    		if (currCount > maxCount) {
-    			maxCount = currCount;
-    			nextVarIndex = i;
-    		}
-    	}
-    }
-
-    // User wants to apply splitting heuristic three, which tries to pick the variable in the current block that appears in the greatest
-    // number of clauses. Unlike the previous heuristic (two), this accounts for the probability of satisfaction and the separate
-    // instances of positive vs negative appearances. In all, it finds the variable that will satisfy the greatest number of clauses in one step
-    // if assigned correctly
-    if (directions == SolutionType::hThree) {
-    	double maxCount = 0.0;
-
-   		// decide the current block
-   		bool choiceVar = (variables->at(nextVarIndex) == -1);
-
-   		// now run through every variable in the current block
-   		bool currBlock = true;
-
-    	for (int i = nextVarIndex; currBlock; i++) {
-    		double currPosCount = 0.0;
-    		double currNegCount = 0.0;
-
-  			// make sure we're still in the block
-    		if (i+1 == varsByClause.size())
-    			currBlock = false;
-    		else if (choiceVar) {
-    			if (variables->at(i+1) != -1)	// chance when there should be choice
-    				currBlock = false;
-    		} else {
-    			if (variables->at(i+1) == -1)	// choice when there should be chance
-    				currBlock = false;
-    		}
-
-
-    		if (assignments->at(i) != 0)
-    			continue;
-
-    		// keep track of the positive and negative appearances
-    		for (unsigned int n = 0; n < varsByClause[i].size(); n++) {
-    			if ((varsByClause[i][n]  / abs(varsByClause[i][n])) == 1)
-    				currPosCount++;
-    			else
-    				currNegCount++;
-    		}
-
-    		// if it's a chance variable, adjust those pos/neg appearances by the probability that those appearances would be satisfied
-    		if (variables->at(i) != -1) {
-    			currPosCount *= variables->at(i);
-    			currNegCount *= (1 - variables->at(i));
-    		}
-
-    		// keep track of the maximum, whatever it is 
-    		// NOTE regardless of pos/neg scores, we will try both options below to cover the trees
-    		if (assignments->at(i) == 0 && std::max(currPosCount, currNegCount) > maxCount ) {
-    			maxCount = std::max(currPosCount, currNegCount);
-    			nextVarIndex = i;
-    		}
-    	}
-    }
+// Generator options, shared by generate and sweep
+// --vars N -- the number of variables (20 by default)
+// --ratio R -- clauses per variable (4 by default)
+// --k K -- literals per clause, all on different variables (3 by default)
+// --blocks B -- the number of quantifier blocks, alternating between choice and chance, over equal runs of variables (2 by default)
+// --chance-first -- start with a chance block rather than a choice block
+// --probs LOW HIGH -- draw chance variable probabilities from [LOW, HIGH] (0 and 1 by default)
+// --seed S -- the seed of the generator (1 by default)
+// @param argc, argv -- the command line
+// @param a -- the position of the option, moved to its last value (ptr)
+// @param options -- the options to set (ptr)
+bool parseGeneratorOption(int argc, char* argv[], int* a, GeneratorOptions* options)
+{
+	std::string option = argv[*a];
 
-    // trying false
-    assignments->at(nextVarIndex) = -1;
+	if (option.compare("--vars") == 0 && *a + 1 < argc)
+		options->numVars = std::max(1, atoi(argv[++*a]));
+	else if (option.compare("--ratio") == 0 && *a + 1 < argc)
+		options->ratio = atof(argv[++*a]);
+	else if (option.compare("--k") == 0 && *a + 1 < argc)
+		options->k = std::max(1, atoi(argv[++*a]));
+	else if (option.compare("--blocks") == 0 && *a + 1 < argc)
+		options->blocks = std::max(1, atoi(argv[++*a]));
+	else if (option.compare("--chance-first") == 0)
+		options->choiceFirst = false;
+	else if (option.compare("--probs") == 0 && *a + 2 < argc) {
+		options->probLow = atof(argv[++*a]);
+		options->probHigh = atof(argv[++*a]);
+	}
+	else if (option.compare("--seed") == 0 && *a + 1 < argc)
+		options->seed = strtoull(argv[++*a], NULL, 10);
+	else
+		return false;
 
-    // NOTE to avoid having to deal with reversing the effects of changes down recursive paths, we
-    // simply make a copy (these vectors move pretty quickly in c++, actually, especially with the right methods!)
-    std::vector<std::vector<int>> falseClauses(clauses);
-    std::vector<int> falseSats(clauseSats);
-    std::vector<int> falseAssignments(*assignments);
-    std::vector<std::vector<int>> falseVBC(varsByClause);
+	return true;
+}
 
-    // satify and test probabilities given false option
-    satisfyClauses(nextVarIndex, &falseClauses, &falseSats, &falseAssignments, &falseVBC);
-    double probSatFalse = solve(directions, variables, falseClauses, falseSats, &falseAssignments, falseVBC);
+// Generates a random k-SSAT instance: the variables are split into equal runs, one per block, each clause has k
+// literals on different variables with random signs, and chance probabilities are rounded to three decimals like
+// the .ssat generator writes them (so an instance solves the same in memory as written out and read back in)
+// NOTE the numbers come from nextRandom() rather than rand() or <random> distributions, so a seed gives the same
+// instance everywhere
+// @param options -- the shape of the instance and the seed
+// @param variables -- a pointer to the vector of variable probabilities to fill
+// @param database -- a pointer to the clause database to fill, occurrence lists and blocks included
+void generateSSAT(const GeneratorOptions& options, std::vector<double>* variables, ClauseDatabase* database)
+{
+	unsigned long long state = options.seed;
+	int numVars = options.numVars;
+	int k = std::min(options.k, numVars);
+	int blocks = std::min(options.blocks, numVars);
 
-    // trying true
-    assignments->at(nextVarIndex) = 1;
+	variables->assign(numVars, -1);
+	for (int v = 0; v < numVars; v++) {
+		bool choice = ((v * blocks / numVars) % 2 == 0) == options.choiceFirst;
+		if (choice)
+			continue;
 
-    // satisfy and test given true option
-    satisfyClauses(nextVarIndex, &clauses, &clauseSats, assignments, &varsByClause);
-    double probSatTrue = solve(directions, variables, clauses, clauseSats, assignments, varsByClause);
+		double unit = (nextRandom(&state) >> 11) * (1.0 / 9007199254740992.0);
+		double prob = options.probLow + unit * (options.probHigh - options.probLow);
+		(*variables)[v] = std::min(1.0, std::max(0.0, floor(prob * 1000 + 0.5) / 1000));
+	}
 
-    if (variables->at(nextVarIndex) == -1) { 	// v is a choice variable
-		return std::max(probSatFalse, probSatTrue);	// so pick the maximum choice to optimize success
-    }
-    
-    // v is a chance variable, so adjust both probabilites to account for all possibilites
-    return probSatTrue * variables->at(nextVarIndex) + probSatFalse * (1 - variables->at(nextVarIndex));
+	int numClauses = (int)(options.ratio * numVars + 0.5);
+	database->literals.clear();
+	database->clauseStart.assign(1, 0);
+
+	for (int c = 0; c < numClauses; c++) {
+		int first = database->literals.size();
+
+		while ((int)database->literals.size() - first < k) {
+			int v = nextRandom(&state) % numVars;
+			bool repeated = false;
+			for (unsigned int i = first; i < database->literals.size(); i++)
+				repeated = repeated || literalVar(database->literals[i]) == v;
+
+			if (!repeated)
+				database->literals.push_back(makeLiteral(v, nextRandom(&state) % 2 == 0));
+		}
+
+		database->clauseStart.push_back(database->literals.size());
+	}
+
+	buildOccurrences(database, numVars);
+	buildBlocks(*variables, database);
 }
 
-// Checks for clause satisfaction and removes newly deactivated literals, as well as updating varsByClause
-// @param varIndex -- the current variable on which the solve algorithm has split
-// @param clauses -- the clauses that can be adjusted directly (ptr)
-// @param sats -- the satisfaction of each clause that can be marked directly (ptr)
-// @param assignments -- assignment values to check (just a ptr for space)
-// @param varsByClause -- a 2d vector of literal appearances that can be adjusted directly (ptr)
-void satisfyClauses(int varIndex, std::vector<std::vector<int>>* clauses, std::vector<int>* sats, std::vector<int>* assignments, std::vector<std::vector<int>>* varsByClause)
-{
-	// how this algorithm is (somewhat naively) set up, we run through every clause to look for variable appearances
-	// how it SHOULD work is to run through varsByClauses, but BOY was that starting to look ugly, there was a segfault, and it really 
-	// wasn't that much faster because you still have to run through all the variables to check for the appearance of a clause (and there are
-	// the same number of vars x clauses as clauses x vars anyways!)
-	// also at this point, we somewhat goofily do not make the assumption that a literl can appear both positively and negatively in the same clause -- we check the
-	// entire clause anyways
-    for (int c = 0; c < (signed int)clauses->size(); c++) {
-    	// if the clauses is already satisfied, ignore it!
-		if (sats->at(c) == 1)
-		    continue;
+// Writes an instance in the .ssat text format that readSSATFile() reads
+// @param fileName -- the name of the file to write
+// @param variables -- the variable probabilities
+// @param database -- the clauses
+int writeSSATFile(std::string fileName, const std::vector<double>& variables, const ClauseDatabase& database)
+{
+	std::ofstream file(fileName);
+	if (!file) {
+		std::cout << "Failed to open " << fileName << " for writing. Exiting." << std::endl;
+		return 1;
+	}
+
+	file << "variables" << std::endl;
+	for (unsigned int v = 0; v < variables.size(); v++) {
+		file << v + 1 << " ";
+		if (variables[v] == -1)
+			file << "-1" << std::endl;
+		else {
+			char prob[16];
+			snprintf(prob, sizeof(prob), "%.3f", variables[v]);
+			file << prob << std::endl;
+		}
+	}
 
-		for (unsigned int l = 0; l < clauses->at(c).size(); l++) {
-		    if (clauses->at(c)[l] == (varIndex + 1) * assignments->at(varIndex)) {	// if we're satisfying a new clause
-				sats->at(c) = 1;													// mark it
+	file << std::endl << "clauses" << std::endl;
+	for (int c = 0; c < database.numClauses(); c++) {
+		for (int i = database.clauseStart[c]; i < database.clauseStart[c + 1]; i++) {
+			int literal = database.literals[i];
+			file << (literalNegative(literal) ? -(literalVar(literal) + 1) : literalVar(literal) + 1) << " ";
+		}
+		file << "0" << std::endl;
+	}
 
-				// and find the appearance of that clause in every variable using fast vector access methods to show that that
-				// variable need no longer be considered active in the clause
-				for (unsigned int v = 0; v < varsByClause->size(); v++) {	
-				    std::vector<int>::iterator it = std::find(varsByClause->at(v).begin(), varsByClause->at(v).end(), (c + 1)  * assignments->at(varIndex));
+	if (!file) {
+		std::cout << "Failed to write " << fileName << ". Exiting." << std::endl;
+		return 1;
+	}
 
-				    if (it != varsByClause->at(v).end())
-						varsByClause->at(v).erase(it);
-				}
-		    }
-		    else if (clauses->at(c)[l] == (varIndex + 1) * assignments->at(varIndex) * -1) {	// if it's appearing UNSATISFIED in the given clause
+	std::cout << "Wrote " << variables.size() << " variables and " << database.numClauses() << " clauses to " << fileName << std::endl;
+	return 0;
+}
+
+// Sweep -- "sweep [options]" generates instances of every size in a list and solves each one with every solution type,
+// reporting the median and 95th percentile solve time and the median nodes for every size and type. Every type must
+// agree with naive on every instance (to within rounding), otherwise the disagreements are listed and it fails
+// Options, besides the generator options above (where --vars is replaced by --sizes and --seed is the first seed):
+// --sizes N,N,... -- the numbers of variables to sweep over (10,15,20,25 by default)
+// --reps R -- how many instances of each size, with consecutive seeds (5 by default)
+// @param argc, argv -- the command line, where argv[1] is "sweep"
+int runSweep(int argc, char* argv[])
+{
+	const char* typeNames = "nupb123";
+	const int numTypes = 7;
+	const double tolerance = 1e-9;
 
-		    	// erase that clause from the current variable
-				varsByClause->at(varIndex).erase(std::find(varsByClause->at(varIndex).begin(), varsByClause->at(varIndex).end(), (c + 1) * assignments->at(varIndex) * -1));
+	GeneratorOptions options = { 20, 4.0, 3, 2, true, 0.0, 1.0, 1 };
+	std::vector<int> sizes;
+	int reps = 5;
 
-				// if you are marking the last remaining literal in the clause as unsatisfied, the entire clause is unsatisfied
-				if (clauses->at(c).size() == 1)
-				    sats->at(c) = -1;
-				else {
-				    clauses->at(c).erase(clauses->at(c).begin() + l);	// otherwise just erase that specific literal from the clause (and we know the spot already!)
-				    l--;												// decrement because of erase
+	for (int a = 2; a < argc; a++) {
+		if (std::string(argv[a]).compare("--sizes") == 0 && a + 1 < argc) {
+			std::string list = argv[++a];
+			for (size_t start = 0; start < list.size(); start = list.find(',', start) + 1) {
+				sizes.push_back(atoi(list.c_str() + start));
+				if (list.find(',', start) == std::string::npos)
+					break;
+			}
+		}
+		else if (std::string(argv[a]).compare("--reps") == 0 && a + 1 < argc)
+			reps = std::max(1, atoi(argv[++a]));
+		else if (!parseGeneratorOption(argc, argv, &a, &options)) {
+			std::cout << "Unknown option " << argv[a] << ". Exiting." << std::endl;
+			return 1;
+		}
+	}
+
+	if (sizes.empty()) {
+		int defaultSizes[] = { 10, 15, 20, 25 };
+		sizes.assign(defaultSizes, defaultSizes + 4);
+	}
+
+	int disagreements = 0;
+	std::cout << "vars\ttype\tmedian ms\tp95 ms\tmedian nodes" << std::endl;
+
+	for (unsigned int z = 0; z < sizes.size(); z++) {
+		std::vector<std::vector<double>> times(numTypes);
+		std::vector<std::vector<long long>> nodes(numTypes);
+
+		for (int r = 0; r < reps; r++) {
+			GeneratorOptions instance = options;
+			instance.numVars = std::max(1, sizes[z]);
+			instance.seed = options.seed + r;
+
+			std::vector<double> variables;
+			ClauseDatabase database;
+			generateSSAT(instance, &variables, &database);
+
+			double naiveProb = 0.0;
+			for (int t = 0; t < numTypes; t++) {
+				SolutionType directions;
+				parseDirections(std::string(1, typeNames[t]), &directions);
+
+				Formula formula;
+				initFormula(&formula, &database, variables.size());
+				initScores(&formula, &variables, directions);
+
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				double prob = solverFor(directions)(&variables, &formula, -INFINITY, INFINITY);
+				times[t].push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000);
+				nodes[t].push_back(formula.stats.nodes);
+
+				if (t == 0)
+					naiveProb = prob;
+				else if (fabs(prob - naiveProb) > tolerance) {
+					std::cout << "DISAGREEMENT: " << instance.numVars << " vars, seed " << instance.seed << ", type "
+							  << typeNames[t] << " gives " << prob << " but naive gives " << naiveProb << std::endl;
+					disagreements++;
 				}
-		    }
+			}
 		}
-    }
+
+		for (int t = 0; t < numTypes; t++) {
+			std::sort(times[t].begin(), times[t].end());
+			std::sort(nodes[t].begin(), nodes[t].end());
+
+			// nearest rank percentiles
+			double median = times[t][(reps + 1) / 2 - 1];
+			double p95 = times[t][(int)ceil(0.95 * reps) - 1];
+			std::cout << sizes[z] << "\t" << typeNames[t] << "\t" << median << "\t" << p95 << "\t" << nodes[t][(reps + 1) / 2 - 1] << std::endl;
+		}
+	}
+
+	if (disagreements > 0) {
+		std::cout << disagreements << " solves disagreed with naive. FAILED" << std::endl;
+		return 1;
+	}
+
+	std::cout << "Every solution type agreed with naive" << std::endl;
+	return 0;
+}
+
+SsatInstance::SsatInstance() : data(NULL)
+{
+}
+
+SsatInstance::~SsatInstance()
+{
+	delete data;
+}
+
+// Reads in an instance (see readSSATFile()), keeping the one it had if the file can't be read
+// @param fileName -- a .ssat or compiled file
+// @param preprocess -- whether to simplify the clauses first (see preprocessSSAT())
+// @param error -- set to why the file couldn't be read (ptr)
+int SsatInstance::load(const std::string& fileName, bool preprocess, std::string* error)
+{
+	Data* loaded = new Data();
+	std::ostringstream log;
+
+	if (readSSATFile(fileName, &loaded->variables, &loaded->database, &log) == 1) {
+		*error = lastError(log.str());
+		delete loaded;
+		return 1;
+	}
+
+	if (preprocess)
+		preprocessSSAT(loaded->variables, &loaded->database, &log);
+
+	delete data;
+	data = loaded;
+	return 0;
+}
+
+int SsatInstance::numVariables() const
+{
+	return data == NULL ? 0 : data->variables.size();
+}
+
+double SsatInstance::probability(int variable) const
+{
+	return data->variables[variable - 1];
+}
+
+// Sets up a solver's formula over the instance, the way the command line would for the same options. Options that
+// can't be solved with are only reported by solve()
+// @param instance -- the loaded instance (ptr)
+// @param options -- the options of every query
+SsatSolver::SsatSolver(const SsatInstance* instance, const SsatOptions& options) : state(new State())
+{
+	state->instance = instance->data;
+	state->options = options;
+
+	if (state->instance == NULL) {
+		state->error = "The instance is not loaded";
+		return;
+	}
+	if (!parseDirections(std::string(1, options.solutionType), &state->directions)) {
+		state->error = std::string("Unknown solution type ") + options.solutionType;
+		return;
+	}
+	if (options.learnLimit > 0 && !learnsClauses(state->directions, options.components)) {
+		state->error = "Learning needs a solution type with unit propagation, and can't be combined with components";
+		return;
+	}
+
+	state->solve = solverFor(state->directions);
+	state->variables = state->instance->variables;
+
+	Formula& formula = state->formula;
+	initFormula(&formula, &state->instance->database, state->variables.size());
+	initScores(&formula, &state->variables, state->directions);
+	formula.components = options.components;
+	formula.prune = options.prune;
+	formula.learned.limit = options.learnLimit;
+
+	if (options.cacheMB > 0) {
+		initCache(&state->cache, options.cacheMB);
+		formula.cache = &state->cache;
+	}
+}
+
+SsatSolver::~SsatSolver()
+{
+	delete state;
+}
+
+// Solves one query. The fixed literals are assigned below the search, the way a pool task assigns its branch (see
+// runTask()), and taken back off afterwards, and the overrides stay in the solver's probabilities until a query with
+// different ones, so a run of queries with the same overrides keeps its cache
+// @param assumptions -- the literals to fix
+// @param overrides -- the chance probabilities to use instead of the instance's
+// @param result -- filled in with the answer (ptr)
+// @param error -- set to what is wrong with the options or the query (ptr)
+int SsatSolver::solve(const std::vector<int>& assumptions, const std::vector<SsatOverride>& overrides, SsatResult* result, std::string* error)
+{
+	if (!state->error.empty()) {
+		*error = state->error;
+		return 1;
+	}
+
+	const std::vector<double>& probabilities = state->instance->variables;
+	int numVars = probabilities.size();
+
+	for (unsigned int i = 0; i < assumptions.size(); i++) {
+		if (assumptions[i] == 0 || std::abs(assumptions[i]) > numVars) {
+			*error = "Assumption " + std::to_string(assumptions[i]) + " is not a literal of the instance";
+			return 1;
+		}
+	}
+
+	for (unsigned int i = 0; i < overrides.size(); i++) {
+		int v = overrides[i].variable;
+		if (v < 1 || v > numVars || probabilities[v - 1] == -1) {
+			*error = "Override of variable " + std::to_string(v) + ", which is not a chance variable";
+			return 1;
+		}
+		if (!(overrides[i].probability >= 0.0 && overrides[i].probability <= 1.0)) {
+			*error = "Override of variable " + std::to_string(v) + " with a probability outside 0 to 1";
+			return 1;
+		}
+	}
+
+	// new probabilities, so nothing worked out with the old ones holds any more
+	bool changed = (overrides.size() != state->overrides.size());
+	for (unsigned int i = 0; !changed && i < overrides.size(); i++) {
+		changed = (overrides[i].variable != state->overrides[i].variable
+				   || overrides[i].probability != state->overrides[i].probability);
+	}
+
+	Formula& formula = state->formula;
+
+	if (changed) {
+		for (unsigned int i = 0; i < state->overrides.size(); i++)
+			state->variables[state->overrides[i].variable - 1] = probabilities[state->overrides[i].variable - 1];
+		for (unsigned int i = 0; i < overrides.size(); i++)
+			state->variables[overrides[i].variable - 1] = overrides[i].probability;
+		state->overrides = overrides;
+
+		if (formula.cache != NULL)
+			initCache(&state->cache, state->options.cacheMB);
+		initScores(&formula, &state->variables, state->directions);
+	}
+
+	formula.stats = SolveStats();
+	if (formula.cache != NULL) {
+		state->cache.hits = 0;
+		state->cache.misses = 0;
+		state->cache.evictions = 0;
+	}
+
+	// clauses learned by earlier queries follow from the clauses alone, so they hold under any assumptions. Their watches
+	// see every assignment of this query, but a single literal one is only queued when it is learned, so each gets the
+	// check a newly learned clause gets (see assertLearned())
+	int numClauses = state->instance->database.numClauses();
+	for (unsigned int k = 0; k < formula.learned.length.size(); k++) {
+		if (formula.learned.length[k] != -1) {
+			formula.learned.pending = numClauses + k;
+			assertLearned(&formula);
+		}
+	}
+	formula.learned.pending = -1;
+
+	// a literal fixed both ways can't be satisfied, and one fixed twice is only assigned once
+	bool contradiction = false;
+	for (unsigned int i = 0; i < assumptions.size(); i++) {
+		int v = std::abs(assumptions[i]) - 1;
+		int value = assumptions[i] > 0 ? 1 : -1;
+
+		if (formula.assignments[v] == -value)
+			contradiction = true;
+		else if (formula.assignments[v] == 0) {
+			assignVariable(v, value, &formula);
+			satisfyClauses(v, &formula);
+		}
+	}
+
+	// the fixed literals are propagated here, before the search, so a conflict between them (which is at no level of the
+	// search and can't be learned from) never reaches it. Unit chance variables scale the answer, as in solve()
+	double weight = 1.0;
+	if (!contradiction && !assumptions.empty())
+		contradiction = !propagateUnits(&formula, &state->variables, &weight) || weight == 0.0;
+
+	double low = -INFINITY;
+	double high = INFINITY;
+	if (state->options.decide) {
+		low = (state->options.threshold - DECISION_TOLERANCE) / weight;
+		high = state->options.threshold / weight;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	double probability = contradiction ? 0.0 : weight * state->solve(&state->variables, &formula, low, high);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	undoTrail(&formula, 0);
+
+	result->probability = probability;
+	result->atLeast = probability > state->options.threshold - DECISION_TOLERANCE;
+	result->nodes = formula.stats.nodes;
+	result->seconds = seconds;
+	result->stats = statsJson(formula.stats, formula.cache, seconds);
+	return 0;
 }
@@ -0,0 +1,100 @@
+//ssat.h.
+//      The SSAT solver of ssat.cpp as a library, for programs that solve many queries without starting a process for each.
+//FUNCTIONAL DESCRIPTION
+//      An SsatInstance is read in once and never changed after that, so any number of SsatSolvers can share it, on
+//      any threads. Each SsatSolver holds the search state of one solve at a time and is only used by one thread at a
+//      time. A query can fix literals and override chance probabilities, which only touches the solver, never the
+//      instance. See the readme for how to build and link it.
+//
+
+#ifndef SSAT_H
+#define SSAT_H
+
+#include <string>
+#include <vector>
+
+// Options for a solver, as on the command line (see the readme)
+// solutionType -- n, u, p, b, 1, 2 or 3
+// cacheMB -- the size of the residual formula cache, 0 for none
+// learnLimit -- how many learned clauses to keep, 0 to learn none (needs unit propagation and no components)
+// decide, threshold -- only decide whether the probability is at least threshold
+struct SsatOptions {
+    char solutionType;
+    bool components;
+    bool prune;
+    unsigned int cacheMB;
+    int learnLimit;
+    bool decide;
+    double threshold;
+
+    SsatOptions() : solutionType('3'), components(false), prune(false), cacheMB(0), learnLimit(0), decide(false), threshold(0.0) {}
+};
+
+// A chance variable's probability for one query, in place of the instance's (variables are numbered from 1, as in the file)
+struct SsatOverride {
+    int variable;
+    double probability;
+};
+
+// The answer to one query: the probability (see --threshold for what it means when deciding), whether it is at least
+// the threshold, the nodes visited, the wall time of the search, and every counter of the search as a JSON object
+// (the "Statistics:" line of the command line)
+struct SsatResult {
+    double probability;
+    bool atLeast;
+    long long nodes;
+    double seconds;
+    std::string stats;
+};
+
+// An instance read in from a .ssat or compiled file, which is read-only once loaded
+class SsatInstance {
+public:
+    SsatInstance();
+    ~SsatInstance();
+
+    // Reads in an instance, preprocessing it if asked (see --preprocess). Returns 1 and sets error if it can't be read
+    int load(const std::string& fileName, bool preprocess, std::string* error);
+
+    // The number of variables, and the probability of variable v (numbered from 1), -1 for a choice variable
+    int numVariables() const;
+    double probability(int variable) const;
+
+    struct Data;
+
+private:
+    SsatInstance(const SsatInstance&) = delete;
+    SsatInstance& operator=(const SsatInstance&) = delete;
+
+    Data* data;
+    friend class SsatSolver;
+};
+
+// Solves queries on a loaded instance, reusing its search state (and learned clauses and cache) from one query to the next
+// NOTE learned clauses follow from the clauses alone, never from a query's literals, so they are kept for the next query
+//      and checked against its literals before it searches
+// NOTE the instance has to stay loaded for as long as the solver is used
+class SsatSolver {
+public:
+    SsatSolver(const SsatInstance* instance, const SsatOptions& options);
+    ~SsatSolver();
+
+    // Solves the instance with some literals fixed (signed variable numbers, as in the clauses of the file) and some
+    // chance probabilities overridden, which only hold for this query. A fixed chance variable is taken as given, so the
+    // probability is conditional on it, and contradictory literals make it 0. Returns 1 and sets error if the options
+    // or the query don't make sense
+    int solve(const std::vector<int>& assumptions, const std::vector<SsatOverride>& overrides, SsatResult* result, std::string* error);
+
+    struct State;
+
+private:
+    SsatSolver(const SsatSolver&) = delete;
+    SsatSolver& operator=(const SsatSolver&) = delete;
+
+    State* state;
+};
+
+// The ssat command line (see the readme), which main.cpp runs
+int runCommandLine(int argc, char* argv[]);
+
+#endif
@@ -0,0 +1,62 @@
+//api_test.cpp.
+//      Checks queries through the library API (see ssat.h) that the command line can't make, on instances in tests/instances.
+//      Built and run by run_tests.sh.
+//
+
+#include "../ssat.h"
+#include <cmath>
+#include <iostream>
+
+int failures = 0;
+
+// Runs one query and checks its answer
+// @param solver -- the solver to query (ptr)
+// @param name -- what the query checks, for the report
+// @param assumptions -- the literals to fix
+// @param expected -- the probability it should come back with
+void check(SsatSolver* solver, const std::string& name, const std::vector<int>& assumptions, double expected)
+{
+	SsatResult result;
+	std::string error;
+
+	if (solver->solve(assumptions, std::vector<SsatOverride>(), &result, &error) == 1) {
+		std::cout << "FAIL  " << name << ": " << error << std::endl;
+		failures++;
+	}
+	else if (std::fabs(result.probability - expected) > 1e-12) {
+		std::cout << "FAIL  " << name << ": expected " << expected << ", got " << result.probability << std::endl;
+		failures++;
+	}
+	else
+		std::cout << "ok    " << name << std::endl;
+}
+
+int main()
+{
+	// the clauses -1 -2 and 3 1, where 1 and 2 are choice variables and 3 is a chance variable with probability 0.5
+	SsatInstance instance;
+	std::string error;
+	if (instance.load("instances/assumption_conflict.ssat", false, &error) == 1) {
+		std::cout << "FAIL  loading: " << error << std::endl;
+		return 1;
+	}
+
+	for (int learn = 0; learn <= 10; learn += 10) {
+		SsatOptions options;
+		options.solutionType = 'u';
+		options.learnLimit = learn;
+		SsatSolver solver(&instance, options);
+		std::string suffix = learn > 0 ? " (learning)" : "";
+
+		// 1 and 2 fail -1 -2 between them, before the search has split on anything
+		check(&solver, "conflicting assumptions" + suffix, { 1, 2, 3 }, 0.0);
+		check(&solver, "no assumptions after a conflict" + suffix, {}, 1.0);
+
+		// 2 forces 1 false, which leaves 3 unit, so the answer is scaled by its chance
+		check(&solver, "assumption forcing a chance variable" + suffix, { 2 }, 0.5);
+		check(&solver, "literal fixed both ways" + suffix, { 1, -1 }, 0.0);
+	}
+
+	std::cout << failures << " API checks failed" << std::endl;
+	return failures == 0 ? 0 : 1;
+}
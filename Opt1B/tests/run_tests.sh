@@ -0,0 +1,33 @@
+#!/bin/sh
+# Builds ssat and checks it against the instances in tests/instances, each of which says on its first line (outside the
+# variables and clauses, so the reader skips it) what the output should contain: the error of a malformed instance, or
+# the solution of a well-formed one, and then runs api_test.cpp. Run from anywhere, with the compiler in CXX (g++ by default)
+
+cd "$(dirname "$0")" || exit 1
+CXX=${CXX:-g++}
+BUILD=$(mktemp -d)
+trap 'rm -rf "$BUILD"' EXIT
+
+$CXX -std=c++11 -O2 -pthread -c ../ssat.cpp -o "$BUILD/ssat.o" || exit 1
+$CXX -std=c++11 -O2 -pthread ../main.cpp "$BUILD/ssat.o" -o "$BUILD/ssat" || exit 1
+$CXX -std=c++11 -O2 -pthread api_test.cpp "$BUILD/ssat.o" -o "$BUILD/api_test" || exit 1
+
+failures=0
+for instance in instances/*.ssat; do
+	expected=$(sed -n '1s/^expect: //p' "$instance")
+	output=$("$BUILD/ssat" b "$instance" --progress 0)
+
+	if printf '%s\n' "$output" | grep -qF "$expected"; then
+		echo "ok    $instance"
+	else
+		echo "FAIL  $instance: expected \"$expected\""
+		printf '%s\n' "$output" | sed 's/^/      /'
+		failures=$((failures + 1))
+	fi
+done
+
+# and the queries only the library can make
+"$BUILD/api_test" || failures=$((failures + 1))
+
+echo "$failures failed"
+[ "$failures" -eq 0 ]